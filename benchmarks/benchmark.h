@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace benchmark {
+
+/// Keeps @p value from being optimized out.
+template <class T>
+void Use(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+/**
+ * Runs @p fn @p iterations times and prints the average time of a run.
+ *
+ * @param[in] name Name of the case to print.
+ * @param[in] iterations Number of runs.
+ * @param[in] fn Function to run.
+ */
+template <class Fn>
+void Run(const std::string& name, std::size_t iterations, Fn&& fn)
+{
+    // warm up caches and allocator
+    fn();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        fn();
+    }
+    const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << std::left << std::setw(48) << name << std::right << std::setw(14) << std::fixed
+              << std::setprecision(1) << elapsed.count() / static_cast<double>(iterations) << " ns\n";
+}
+
+} // namespace benchmark
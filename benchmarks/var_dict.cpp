@@ -0,0 +1,81 @@
+#include "benchmark.h"
+
+#include <uri-template/uri-template.h>
+
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+/// Get key/value pairs "k0" = "v0", "k1" = "v1"...
+std::vector<std::pair<std::string, std::string>> MakeItems(std::size_t size)
+{
+    std::vector<std::pair<std::string, std::string>> items;
+    for (std::size_t i = 0; i < size; ++i) {
+        items.emplace_back("k" + std::to_string(i), "v" + std::to_string(i));
+    }
+    return items;
+}
+
+/// Compares filling, lookups, expansion and matching of dictionaries of @p size items.
+void Compare(std::size_t size, std::size_t iterations)
+{
+    const auto items = MakeItems(size);
+    const std::string suffix = " (" + std::to_string(size) + " items)";
+
+    benchmark::Run("fill unordered_map" + suffix, iterations, [&items]() {
+        std::unordered_map<std::string, std::string> dict;
+        for (const auto& [key, value] : items) {
+            dict.emplace(key, value);
+        }
+        benchmark::Use(dict);
+    });
+    benchmark::Run("fill VarDict" + suffix, iterations, [&items]() {
+        URI::Template::VarDict dict;
+        for (const auto& [key, value] : items) {
+            dict.emplace(key, value);
+        }
+        benchmark::Use(dict);
+    });
+
+    const std::unordered_map<std::string, std::string> map(items.begin(), items.end());
+    URI::Template::VarDict var_dict;
+    for (const auto& [key, value] : items) {
+        var_dict.emplace(key, value);
+    }
+    benchmark::Run("find all in unordered_map" + suffix, iterations, [&items, &map]() {
+        for (const auto& item : items) {
+            benchmark::Use(map.find(item.first));
+        }
+    });
+    benchmark::Run("find all in VarDict" + suffix, iterations, [&items, &var_dict]() {
+        for (const auto& item : items) {
+            benchmark::Use(var_dict.find(item.first));
+        }
+    });
+
+    const auto uri_template = URI::Template::ParseTemplate("/search{?keys*}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"keys", URI::Template::VarValue(URI::Template::VarDict(var_dict))}};
+    benchmark::Run("expand VarDict" + suffix, iterations, [&uri_template, &values]() {
+        benchmark::Use(URI::Template::ExpandTemplate(uri_template, values));
+    });
+
+    const std::string uri = URI::Template::ExpandTemplate(uri_template, values);
+    benchmark::Run("match VarDict" + suffix, iterations, [&uri_template, &uri]() {
+        std::unordered_map<std::string, URI::Template::VarValue> matched;
+        URI::Template::MatchURI(uri_template, uri, &matched);
+        benchmark::Use(matched);
+    });
+}
+
+} // namespace
+
+int main()
+{
+    Compare(8, 100000);
+    Compare(64, 10000);
+    Compare(1000, 1000);
+    return 0;
+}
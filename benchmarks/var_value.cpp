@@ -0,0 +1,58 @@
+#include "benchmark.h"
+
+#include <uri-template/uri-template.h>
+
+#include <vector>
+
+int main()
+{
+    std::cout << "sizeof(VarValue): " << sizeof(URI::Template::VarValue) << " bytes\n";
+
+    constexpr std::size_t kValues = 1000;
+    benchmark::Run("construct 1000 short strings", 1000, []() {
+        std::vector<URI::Template::VarValue> values;
+        values.reserve(kValues);
+        for (std::size_t i = 0; i < kValues; ++i) {
+            values.emplace_back("value");
+        }
+        benchmark::Use(values);
+    });
+
+    std::vector<URI::Template::VarValue> mixed;
+    for (std::size_t i = 0; i < kValues; ++i) {
+        switch (i % 4) {
+        case 0:
+            mixed.emplace_back("short");
+            break;
+        case 1:
+            mixed.emplace_back(static_cast<std::int64_t>(i));
+            break;
+        case 2:
+            mixed.emplace_back(std::vector<std::string>{"a", "b", "c"});
+            break;
+        case 3:
+            mixed.emplace_back(URI::Template::VarDict{{"k", "v"}});
+            break;
+        }
+    }
+    benchmark::Run("copy 1000 mixed values", 1000, [&mixed]() {
+        std::vector<URI::Template::VarValue> copy = mixed;
+        benchmark::Use(copy);
+    });
+
+    const auto uri_template = URI::Template::ParseTemplate("/users/{id}/items{/item}{?q,page}");
+    const std::string uri = "/users/12345/items/abc?q=query&page=2";
+    benchmark::Run("match 4 variables", 100000, [&uri_template, &uri]() {
+        std::unordered_map<std::string, URI::Template::VarValue> values;
+        URI::Template::MatchURI(uri_template, uri, &values);
+        benchmark::Use(values);
+    });
+
+    std::unordered_map<std::string, URI::Template::VarValue> values;
+    URI::Template::MatchURI(uri_template, uri, &values);
+    benchmark::Run("expand 4 variables", 100000, [&uri_template, &values]() {
+        const std::string expanded = URI::Template::ExpandTemplate(uri_template, values);
+        benchmark::Use(expanded);
+    });
+    return 0;
+}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include "Expander.h"
+
+#include <cstdint>
+
+namespace URI {
+namespace Template {
+
+/**
+ * Expansions of a template over many rows of values.
+ * All expansions are stored one after another in a single buffer, expansion of row i is
+ *  `buffer[offsets[i], offsets[i + 1])`.
+ */
+struct ExpandedBatch
+{
+    std::string buffer; ///< Concatenated expansions.
+    std::vector<std::size_t> offsets; ///< Start of each expansion in buffer and the end of the last one.
+
+    /// Get the number of expansions.
+    std::size_t Size() const
+    {
+        return offsets.empty() ? 0 : offsets.size() - 1;
+    }
+
+    /// Get expansion of the @p row.
+    std::string_view operator[](std::size_t row) const
+    {
+        return std::string_view(buffer).substr(offsets[row], offsets[row + 1] - offsets[row]);
+    }
+};
+
+/**
+ * Expansion plan compiled from a template.
+ * Template parts are compiled once into a flat sequence of instructions: literal copies and
+ *  expression expansions with operator properties resolved beforehand. Expanding the plan doesn't dispatch
+ *  on template parts and doesn't make virtual calls to operators and modifiers.
+ * Use it for templates which are expanded many times. The result is the same as of ExpandTemplate().
+ */
+class CompiledExpander
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Compiles @p uri_template into the expansion plan. Adjacent literals are merged.
+     * Compiled plan doesn't refer to @p uri_template, so the template may be destroyed afterwards.
+     *
+     * @param[in] uri_template A template to compile.
+     *
+     * @throws std::runtime_error if template has an empty expression.
+     */
+    explicit CompiledExpander(const Template& uri_template);
+
+    /// Copy constructor.
+    CompiledExpander(const CompiledExpander&) = default;
+    /// Copy assignment.
+    CompiledExpander& operator=(const CompiledExpander&) = default;
+    /// Move constructor.
+    CompiledExpander(CompiledExpander&&) noexcept = default;
+    /// Move assignment.
+    CompiledExpander& operator=(CompiledExpander&&) noexcept = default;
+
+    /// Destructor.
+    ~CompiledExpander() = default;
+
+    /**
+     * Expands the compiled template into a string.
+     * Variables which are not in @p values treated as undefined.
+     *
+     * @param[in] values Variables values to use for expansion.
+     *
+     * @returns Expansion result.
+     */
+    std::string Expand(const std::unordered_map<std::string, VarValue>& values) const;
+
+    /**
+     * Expands the compiled template into a buffer.
+     * Same as Expand() above, but appends the result to the end of @p result.
+     *
+     * @param[in] values Variables values to use for expansion.
+     * @param[out] result A string to append expansion result to.
+     */
+    void Expand(const std::unordered_map<std::string, VarValue>& values, std::string& result) const;
+
+    /**
+     * Expands the compiled template into a sink.
+     * Same as Expand() above, but appends the result to @p sink.
+     *
+     * @param[in] values Variables values to use for expansion.
+     * @param[out] sink A sink to append expansion result to.
+     */
+    void Expand(const std::unordered_map<std::string, VarValue>& values, OutputSink sink) const;
+
+    /**
+     * Expands the compiled template into a string.
+     * Values are taken from @p values by slots of the variables, see VariableIndex().
+     *
+     * @param[in] values Variables values to use for expansion.
+     *
+     * @returns Expansion result.
+     */
+    std::string Expand(BoundValues values) const;
+
+    /**
+     * Expands the compiled template into a buffer.
+     * Same as Expand() above, but appends the result to the end of @p result.
+     *
+     * @param[in] values Variables values to use for expansion.
+     * @param[out] result A string to append expansion result to.
+     */
+    void Expand(BoundValues values, std::string& result) const;
+
+    /**
+     * Expands the compiled template into a sink.
+     * Same as Expand() above, but appends the result to @p sink.
+     *
+     * @param[in] values Variables values to use for expansion.
+     * @param[out] sink A sink to append expansion result to.
+     */
+    void Expand(BoundValues values, OutputSink sink) const;
+
+    /**
+     * Expands the compiled template for every row of columnar values.
+     * Each column holds values of a single variable, value at position i belongs to row i. The number of rows is
+     *  the size of the longest column, values past the end of a shorter column and variables without a column
+     *  are treated as undefined. Columns are matched with variables once for the whole batch.
+     * Rows are split between @p threads in contiguous ranges, order of the results is the order of the rows.
+     *
+     * @param[in] columns Values of the variables by names.
+     * @param[in] threads Number of threads to use, 0 means std::thread::hardware_concurrency().
+     *
+     * @returns Expansions of all rows.
+     */
+    ExpandedBatch ExpandBatch(const std::unordered_map<std::string, BoundValues>& columns,
+                              std::size_t threads = 1) const;
+
+    /**
+     * Get names of the variables in the compiled template.
+     * The same as Template::VariableNames() of the source template.
+     *
+     * @returns A const reference to vector of variables names.
+     */
+    const std::vector<std::string>& VariableNames() const;
+
+    /**
+     * Get the slot of a variable.
+     * The same as Template::VariableIndex() of the source template.
+     *
+     * @param[in] name Name of the variable.
+     *
+     * @returns Slot of the variable wrapped in std::optional or std::nullopt if the template doesn't have it.
+     */
+    std::optional<std::size_t> VariableIndex(const std::string& name) const;
+
+    /**
+     * Get total size of the literals.
+     *
+     * @returns The number of characters every expansion has regardless of variables values.
+     */
+    std::size_t LiteralSize() const;
+
+private:
+    /// Instruction type.
+    enum class OpCode : std::uint8_t
+    {
+        LITERAL, ///< copy literal
+        EXPRESSION ///< expand expression
+    };
+
+    /// Single instruction of the plan.
+    struct Instruction
+    {
+        OpCode code; ///< Instruction type.
+        char first; ///< Expression operator first character.
+        char separator; ///< Expression operator separator.
+        bool named; ///< If expression operator is named.
+        bool empty_eq; ///< If expression operator uses '=' for empty values.
+        bool reserved; ///< If expression operator allows reserved characters.
+        std::size_t begin; ///< Literal start in literals_ or first variable in variables_.
+        std::size_t end; ///< Literal end in literals_ or past the last variable in variables_.
+    };
+
+    /// Variable of an expression.
+    struct VariableInfo
+    {
+        std::string name; ///< Variable name.
+        bool prefixed; ///< If the variable has ModifierType::LENGTH modifier.
+        bool exploded; ///< If the variable has ModifierType::EXPLODE modifier.
+        unsigned length; ///< Prefix length.
+        std::size_t slot; ///< Variable slot.
+    };
+
+    /**
+     * Runs the plan writing to @p sink.
+     * Values are located with `const VarValue* lookup(const VariableInfo&)`, nullptr means undefined variable.
+     */
+    template <class Sink, class Lookup>
+    void ExpandTo(Lookup&& lookup, Sink& sink) const;
+
+    std::vector<Instruction> instructions_; ///< The plan.
+    std::vector<VariableInfo> variables_; ///< Variables of all expressions.
+    std::vector<std::string> names_; ///< Variables names by slots.
+    std::unordered_map<std::string, std::size_t> slots_; ///< Slots of the variables by names.
+    std::string literals_; ///< Literals of the template, concatenated.
+};
+
+/**
+ * Expands uri-template for every row of columnar values.
+ * Same as CompiledExpander::ExpandBatch(), the template is compiled once for the batch.
+ *
+ * @param[in] uri_template A template to expand.
+ * @param[in] columns Values of the variables by names.
+ * @param[in] threads Number of threads to use, 0 means std::thread::hardware_concurrency().
+ *
+ * @returns Expansions of all rows.
+ * @throws std::runtime_error if template has an empty expression.
+ */
+ExpandedBatch ExpandBatch(const Template& uri_template, const std::unordered_map<std::string, BoundValues>& columns,
+                          std::size_t threads = 1);
+
+} // namespace Template
+} // namespace URI
@@ -2,11 +2,318 @@
 
 #include "Template.h"
 
+#include <array>
+#include <cstdint>
 #include <limits>
+#include <memory_resource>
+#include <optional>
+#include <string_view>
+#include <type_traits>
 
 namespace URI {
 namespace Template {
 
+/**
+ * Status of expansion which may fail without throwing.
+ */
+enum class ExpansionStatus
+{
+    OK, /**< expansion is complete */
+    OUTPUT_LIMIT_EXCEEDED, /**< expansion is longer than allowed */
+    TRUNCATED /**< expansion doesn't fit the buffer */
+};
+
+/**
+ * Result of expansion into a caller-provided buffer.
+ */
+struct ExpandIntoResult
+{
+    ExpansionStatus status; ///< ExpansionStatus::OK or ExpansionStatus::TRUNCATED.
+    std::size_t size; ///< Size of the expansion: used part of the buffer or the size needed if truncated.
+};
+
+/**
+ * Type-erased reference to an output sink.
+ * A sink is any object with `append(const char*, std::size_t)` and `push_back(char)` methods,
+ *  e.g. std::string. Expansion appends its result to the sink piece by piece.
+ * @note OutputSink doesn't own the sink, so the sink should outlive it.
+ */
+class OutputSink
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Creates a reference to @p sink.
+     *
+     * @tparam Sink Type of the sink.
+     *
+     * @param[in] sink A sink to refer to.
+     */
+    template <class Sink, typename = std::enable_if_t<!std::is_same<std::decay_t<Sink>, OutputSink>::value>>
+    OutputSink(Sink& sink)
+        : sink_(&sink)
+        , append_([](void* sink, const char* data, std::size_t size) { static_cast<Sink*>(sink)->append(data, size); })
+        , push_back_([](void* sink, char c) { static_cast<Sink*>(sink)->push_back(c); })
+    {
+    }
+
+    /// Appends @p size characters starting from @p data to the sink.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        append_(sink_, data, size);
+    }
+
+    /// Appends a single character @p c to the sink.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        push_back_(sink_, c);
+    }
+
+private:
+    void* sink_; ///< Referred sink.
+    void (*append_)(void*, const char*, std::size_t); ///< Sink's append().
+    void (*push_back_)(void*, char); ///< Sink's push_back().
+};
+
+/**
+ * Type-erased reference to a values resolver.
+ * A resolver is any callable `std::optional<VarValueView>(std::string_view name)` which returns a view of
+ *  the variable value by its name, or std::nullopt if the variable is undefined. Allows to expand values
+ *  from custom objects (e.g. request contexts or JSON documents) without building a map of values.
+ * @note ValueResolver doesn't own the resolver, so the resolver should outlive it.
+ */
+class ValueResolver
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Creates a reference to @p resolver.
+     *
+     * @tparam Resolver Type of the resolver.
+     *
+     * @param[in] resolver A resolver to refer to.
+     */
+    template <class Resolver,
+              typename = std::enable_if_t<!std::is_same<std::decay_t<Resolver>, ValueResolver>::value &&
+                                          std::is_invocable_r<std::optional<VarValueView>, Resolver&,
+                                                              std::string_view>::value>>
+    ValueResolver(Resolver&& resolver)
+        : resolver_(const_cast<void*>(static_cast<const void*>(&resolver)))
+        , resolve_([](void* resolver, std::string_view name) -> std::optional<VarValueView> {
+            return (*static_cast<std::remove_reference_t<Resolver>*>(resolver))(name);
+        })
+    {
+    }
+
+    /// Resolves value of the variable @p name.
+    std::optional<VarValueView> operator()(std::string_view name) const
+    {
+        return resolve_(resolver_, name);
+    }
+
+private:
+    void* resolver_; ///< Referred resolver.
+    std::optional<VarValueView> (*resolve_)(void*, std::string_view); ///< Resolver's call operator.
+};
+
+/**
+ * Variables values bound to slots.
+ * Non-owning view of a contiguous array of values, where value at position i is the value of the variable
+ *  in slot i (see Template::VariableIndex()). Values past the end of the array are treated as undefined.
+ * Expansion from bound values doesn't lookup variables by their names.
+ * @note BoundValues doesn't own the values, so they should outlive it.
+ */
+class BoundValues
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Creates a view of @p size values starting from @p values.
+     *
+     * @param[in] values Pointer to the first value.
+     * @param[in] size Number of values.
+     */
+    BoundValues(const VarValue* values, std::size_t size)
+        : values_(values)
+        , size_(size)
+    {
+    }
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of @p values vector.
+     *
+     * @param[in] values Values to view.
+     */
+    BoundValues(const std::vector<VarValue>& values)
+        : BoundValues(values.data(), values.size())
+    {
+    }
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of @p values array.
+     *
+     * @tparam N Size of the array.
+     *
+     * @param[in] values Values to view.
+     */
+    template <std::size_t N>
+    BoundValues(const std::array<VarValue, N>& values)
+        : BoundValues(values.data(), N)
+    {
+    }
+
+    /// Get number of values.
+    std::size_t Size() const
+    {
+        return size_;
+    }
+
+    /**
+     * Get the value in a slot.
+     *
+     * @param[in] slot Slot of the value.
+     *
+     * @returns Pointer to the value or nullptr if @p slot is out of range.
+     */
+    const VarValue* Find(std::size_t slot) const
+    {
+        return slot < size_ ? values_ + slot : nullptr;
+    }
+
+private:
+    const VarValue* values_; ///< The first value.
+    std::size_t size_; ///< Number of values.
+};
+
+/**
+ * Layer of variables values in a stack of scopes.
+ * Scope refers to a map of values and to an optional parent scope. Variable which is not in the map is looked up
+ *  in the parent scope, then in its parent and so on, so inner scopes override outer ones without merging maps.
+ * Long-living scopes (e.g. defaults and tenant values) are built once and shared by per-request scopes.
+ * @note ValueScope doesn't own the values and the parent, so they should outlive it.
+ */
+class ValueScope
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Creates a scope of @p values on top of @p parent.
+     *
+     * @param[in] values Values of the scope.
+     * @param[in] parent Outer scope or nullptr for the outermost one.
+     */
+    explicit ValueScope(const std::unordered_map<std::string, VarValue>& values, const ValueScope* parent = nullptr)
+        : values_(values)
+        , parent_(parent)
+    {
+    }
+
+    /**
+     * Get the value of a variable from the innermost scope which has it.
+     *
+     * @param[in] name Name of the variable.
+     *
+     * @returns Pointer to the value or nullptr if no scope has the variable.
+     */
+    const VarValue* Find(const std::string& name) const
+    {
+        for (const ValueScope* scope = this; scope != nullptr; scope = scope->parent_) {
+            const auto value_lookup = scope->values_.find(name);
+            if (value_lookup != scope->values_.end()) {
+                return &value_lookup->second;
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    const std::unordered_map<std::string, VarValue>& values_; ///< Values of the scope.
+    const ValueScope* parent_; ///< Outer scope.
+};
+
+namespace detail { // NOLINT(readability-identifier-naming)
+class ScatterSink;
+} // namespace detail
+
+/**
+ * Contiguous piece of expansion.
+ * Has the same layout as POSIX `struct iovec` (checked when the library is built on POSIX systems), so an array of
+ *  segments may be passed to writev() or sendmsg() by casting its data() to `const iovec*`.
+ */
+struct ExpansionSegment
+{
+    const char* data; ///< The first character.
+    std::size_t size; ///< Number of characters.
+};
+
+/**
+ * Expansion split into segments.
+ * Literals of the template are not copied, their segments point into the template. Only expressions are written
+ *  into the scratch buffer of the expansion. Adjacent expressions share a segment.
+ * The same object may be reused for many expansions to reuse its buffers.
+ * @note Segments are valid while the template is alive and unchanged, and until the next expansion into this object.
+ */
+class ScatteredExpansion
+{
+public:
+    /// Default constructor.
+    ScatteredExpansion() = default;
+
+    /// Copy constructor, segments of the copy refer to its own scratch buffer.
+    ScatteredExpansion(const ScatteredExpansion& other);
+
+    /// Move constructor, segments of the moved expansion refer to its own scratch buffer.
+    ScatteredExpansion(ScatteredExpansion&& other) noexcept;
+
+    /// Copy assignment, segments of the copy refer to its own scratch buffer.
+    ScatteredExpansion& operator=(const ScatteredExpansion& other);
+
+    /// Move assignment, segments of the moved expansion refer to its own scratch buffer.
+    ScatteredExpansion& operator=(ScatteredExpansion&& other) noexcept;
+
+    /// Destructor.
+    ~ScatteredExpansion() = default;
+
+    /// Get segments of the expansion in order.
+    const std::vector<ExpansionSegment>& Segments() const
+    {
+        return segments_;
+    }
+
+    /// Get total number of characters in the segments.
+    std::size_t Size() const
+    {
+        return size_;
+    }
+
+    /// Get the expansion as a single string.
+    std::string String() const
+    {
+        std::string result;
+        result.reserve(size_);
+        for (const auto& segment : segments_) {
+            result.append(segment.data, segment.size);
+        }
+        return result;
+    }
+
+private:
+    friend class detail::ScatterSink;
+
+    /// Offset of segments which refer to literals of the template.
+    static constexpr std::size_t kLiteralOffset = std::numeric_limits<std::size_t>::max();
+
+    /// Points segments of the scratch buffer into it.
+    void RebaseScratch();
+
+    std::vector<ExpansionSegment> segments_; ///< Segments of the expansion.
+    std::vector<std::size_t> scratch_offsets_; ///< Offsets of segments in scratch_, kLiteralOffset for literals.
+    std::string scratch_; ///< Expanded expressions.
+    std::size_t size_ = 0; ///< Total size of the segments.
+};
+
 /**
  * Performs percent-encoding of the string.
  * Will percent-encode incoming @p value. If @p allow_reserved is true then the characters from reserved
@@ -22,6 +329,19 @@ namespace Template {
 std::string PctEncode(const std::string& value, bool allow_reserved = false,
                       std::size_t max_len = std::numeric_limits<size_t>::max());
 
+/**
+ * Performs percent-encoding of the string into a buffer.
+ * Same as PctEncode() above, but appends encoded @p value to the end of @p result instead of returning a new string.
+ * The size of the encoded value is calculated beforehand, so @p result grows at most once per call.
+ *
+ * @param[in] value A value to encode.
+ * @param[out] result A string to append encoded value to.
+ * @param[in] allow_reserved If reserved characters are allowed in the result.
+ * @param[in] max_len Maximum length of the result. Encoded triplets are counted as single character.
+ */
+void PctEncode(std::string_view value, std::string& result, bool allow_reserved = false,
+               std::size_t max_len = std::numeric_limits<size_t>::max());
+
 /**
  * Expands a single template expression.
  * Expands an @p expression into a string according to the rules from https://tools.ietf.org/html/rfc6570#section-3.2.
@@ -34,6 +354,29 @@ std::string PctEncode(const std::string& value, bool allow_reserved = false,
  */
 std::string ExpandExpression(const Expression& expression, const std::unordered_map<std::string, VarValue>& values);
 
+/**
+ * Expands a single template expression into a buffer.
+ * Same as ExpandExpression() above, but appends the result to the end of @p result.
+ * Allows to reuse the same buffer for many expansions.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const std::unordered_map<std::string, VarValue>& values,
+                      std::string& result);
+
+/**
+ * Expands a single template expression into a sink.
+ * Same as ExpandExpression() above, but appends the result to @p sink.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const std::unordered_map<std::string, VarValue>& values,
+                      OutputSink sink);
+
 /**
  * Expands uri-template into a string.
  * Expands an @p uri_template into a string according to the rules from https://tools.ietf.org/html/rfc6570#section-3
@@ -46,5 +389,401 @@ std::string ExpandExpression(const Expression& expression, const std::unordered_
  */
 std::string ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values);
 
+/**
+ * Expands uri-template into a buffer.
+ * Same as ExpandTemplate() above, but appends the result to the end of @p result.
+ * Allows to reuse the same buffer for many expansions.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                    std::string& result);
+
+/**
+ * Expands uri-template into a sink.
+ * Same as ExpandTemplate() above, but appends the result to @p sink.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                    OutputSink sink);
+
+/**
+ * Expands uri-template into a buffer, limiting the size of the expansion.
+ * Same as ExpandTemplate() above, but stops as soon as the expansion gets longer than @p max_output_bytes.
+ *  Values which are too long to fit are rejected before they are encoded, and lists and dictionaries are not
+ *  walked past the limit, so the work is bounded by the limit rather than by the size of the values.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] result A string to append expansion result to. Left as is if the limit is exceeded.
+ * @param[in] max_output_bytes Maximum number of characters to append to @p result.
+ *
+ * @returns ExpansionStatus::OK or ExpansionStatus::OUTPUT_LIMIT_EXCEEDED.
+ */
+ExpansionStatus ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                               std::string& result, std::size_t max_output_bytes);
+
+/**
+ * Expands uri-template into segments.
+ * Same as ExpandTemplate() above, but literals of @p uri_template are referred to instead of being copied.
+ *  The previous content of @p result is replaced.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] result Segments of the expansion.
+ */
+void ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                    ScatteredExpansion& result);
+
+/**
+ * Expands uri-template into a caller-provided buffer.
+ * Same as ExpandTemplate() above, but writes the result to @p buffer and doesn't allocate memory.
+ *  If the expansion doesn't fit, the buffer has its first @p capacity characters and the needed size is returned,
+ *  so the caller may retry with a larger buffer. The result is not null-terminated.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[out] buffer A buffer to write expansion result to.
+ * @param[in] capacity Size of the @p buffer.
+ *
+ * @returns Status and size of the expansion.
+ */
+ExpandIntoResult ExpandInto(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                            char* buffer, std::size_t capacity);
+
+/**
+ * Expands uri-template from values views into a caller-provided buffer.
+ * Same as ExpandInto() above, but values are not owned by @p values.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] buffer A buffer to write expansion result to.
+ * @param[in] capacity Size of the @p buffer.
+ *
+ * @returns Status and size of the expansion.
+ */
+ExpandIntoResult ExpandInto(const Template& uri_template,
+                            const std::unordered_map<std::string_view, VarValueView>& values, char* buffer,
+                            std::size_t capacity);
+
+/**
+ * Expands a single template expression from values views.
+ * Same as ExpandExpression() above, but values are not owned by @p values. Allows to expand values
+ *  stored elsewhere (e.g. request buffers) without copying them into VarValue.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandExpression(const Expression& expression,
+                             const std::unordered_map<std::string_view, VarValueView>& values);
+
+/**
+ * Expands a single template expression from values views into a buffer.
+ * Same as ExpandExpression() above, but appends the result to the end of @p result.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const std::unordered_map<std::string_view, VarValueView>& values,
+                      std::string& result);
+
+/**
+ * Expands a single template expression from values views into a sink.
+ * Same as ExpandExpression() above, but appends the result to @p sink.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const std::unordered_map<std::string_view, VarValueView>& values,
+                      OutputSink sink);
+
+/**
+ * Expands uri-template from values views.
+ * Same as ExpandTemplate() above, but values are not owned by @p values. Allows to expand values
+ *  stored elsewhere (e.g. request buffers) without copying them into VarValue.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandTemplate(const Template& uri_template,
+                           const std::unordered_map<std::string_view, VarValueView>& values);
+
+/**
+ * Expands uri-template from values views into a buffer.
+ * Same as ExpandTemplate() above, but appends the result to the end of @p result.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string_view, VarValueView>& values,
+                    std::string& result);
+
+/**
+ * Expands uri-template from values views into a sink.
+ * Same as ExpandTemplate() above, but appends the result to @p sink.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string_view, VarValueView>& values,
+                    OutputSink sink);
+
+/**
+ * Expands a single template expression with values from a resolver.
+ * Same as ExpandExpression() above, but values are requested from @p resolver by names.
+ * The resolver is called once for every variable of the @p expression and only for them.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandExpression(const Expression& expression, ValueResolver resolver);
+
+/**
+ * Expands a single template expression with values from a resolver into a buffer.
+ * Same as ExpandExpression() above, but appends the result to the end of @p result.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, ValueResolver resolver, std::string& result);
+
+/**
+ * Expands a single template expression with values from a resolver into a sink.
+ * Same as ExpandExpression() above, but appends the result to @p sink.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, ValueResolver resolver, OutputSink sink);
+
+/**
+ * Expands uri-template with values from a resolver.
+ * Same as ExpandTemplate() above, but values are requested from @p resolver by names.
+ * The resolver is called once for every variable occurrence in the @p uri_template and only for them,
+ *  so the cost doesn't depend on the number of values the resolver is able to provide.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandTemplate(const Template& uri_template, ValueResolver resolver);
+
+/**
+ * Expands uri-template with values from a resolver into a buffer.
+ * Same as ExpandTemplate() above, but appends the result to the end of @p result.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, ValueResolver resolver, std::string& result);
+
+/**
+ * Expands uri-template with values from a resolver into a sink.
+ * Same as ExpandTemplate() above, but appends the result to @p sink.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] resolver Resolver of variables values.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, ValueResolver resolver, OutputSink sink);
+
+/**
+ * Expands a single template expression with values from a stack of scopes.
+ * Same as ExpandExpression() above, but each variable is taken from the innermost scope which has it.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandExpression(const Expression& expression, const ValueScope& scope);
+
+/**
+ * Expands a single template expression with values from a stack of scopes into a buffer.
+ * Same as ExpandExpression() above, but appends the result to the end of @p result.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const ValueScope& scope, std::string& result);
+
+/**
+ * Expands a single template expression with values from a stack of scopes into a sink.
+ * Same as ExpandExpression() above, but appends the result to @p sink.
+ *
+ * @param[in] expression A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandExpression(const Expression& expression, const ValueScope& scope, OutputSink sink);
+
+/**
+ * Expands uri-template with values from a stack of scopes.
+ * Same as ExpandTemplate() above, but each variable is taken from the innermost scope which has it.
+ * The result is the same as of expansion with scopes merged into a single map, inner values overriding outer ones.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ *
+ * @returns Expansion result.
+ */
+std::string ExpandTemplate(const Template& uri_template, const ValueScope& scope);
+
+/**
+ * Expands uri-template with values from a stack of scopes into a buffer.
+ * Same as ExpandTemplate() above, but appends the result to the end of @p result.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const ValueScope& scope, std::string& result);
+
+/**
+ * Expands uri-template with values from a stack of scopes into a sink.
+ * Same as ExpandTemplate() above, but appends the result to @p sink.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] scope The innermost scope of variables values.
+ * @param[out] sink A sink to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const ValueScope& scope, OutputSink sink);
+
+/**
+ * Expands uri-template into a string allocated from a memory resource.
+ * Same as ExpandTemplate() above, but the result is allocated from @p resource.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[in] resource Memory resource to allocate the result from.
+ *
+ * @returns Expansion result.
+ */
+std::pmr::string ExpandTemplate(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                                std::pmr::memory_resource* resource);
+
+/**
+ * Expands uri-template from values views into a string allocated from a memory resource.
+ * Same as ExpandTemplate() above, but the map of views and the result are allocator-aware,
+ *  so the values and the result may live in a per-request arena (e.g. std::pmr::monotonic_buffer_resource).
+ * @note The template itself isn't allocator-aware, it's meant to be parsed once and shared between requests.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[in] resource Memory resource to allocate the result from, nullptr to use the resource of @p values.
+ *
+ * @returns Expansion result.
+ */
+std::pmr::string ExpandTemplate(const Template& uri_template,
+                                const std::pmr::unordered_map<std::string_view, VarValueView>& values,
+                                std::pmr::memory_resource* resource);
+
+/**
+ * Expands uri-template from values views into an allocator-aware buffer.
+ * Same as ExpandTemplate() above, but appends the result to the end of @p result.
+ *
+ * @param[in] uri_template A template expression to expand.
+ * @param[in] values Views of variables values to use for expansion.
+ * @param[out] result A string to append expansion result to.
+ */
+void ExpandTemplate(const Template& uri_template, const std::pmr::unordered_map<std::string_view, VarValueView>& values,
+                    std::pmr::string& result);
+
+/**
+ * Binds some variables of uri-template to values.
+ * Expressions which have all their variables in @p values are expanded and turned into literals,
+ *  other expressions are kept as is. Adjacent literals are merged.
+ * Partly bound expressions are split into literals and expressions of the unbound variables,
+ *  e.g. "{?q,page}" with bound "q" becomes "?q=value{&page}". That is possible for "/", ".", ";" and "&"
+ *  operators, and for "?" operator if the first variable of the expression is bound. If the bound variables
+ *  at the start of a "?" expression expand to nothing, e.g. they are empty lists, the rest is kept as "?" expression
+ *  and must not have bound variables.
+ * Expanding the result with the rest of the variables is the same as expanding @p uri_template with all of them,
+ *  except that characters which are not allowed in literals (only "'" of "+" and "#" operators) are
+ *  percent-encoded in the bound part.
+ * Use it for variables which are fixed for a long time, e.g. a host or an API version, so per-request expansion
+ *  and matching handle only the rest.
+ *
+ * @param[in] uri_template A template to bind variables of.
+ * @param[in] values Values of the variables to bind. VarValue() binds the variable as undefined.
+ *
+ * @returns Template with bound variables.
+ * @throws std::runtime_error if template has an empty expression.
+ * @throws std::invalid_argument if an expression is partly bound and can't be split.
+ */
+Template BindPartial(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values);
+
+/**
+ * Calculates the size of uri-template expansion.
+ * Returns exact number of characters ExpandTemplate() would produce for the same arguments,
+ *  without building the expansion. Operator characters, names of named variables, prefix modifiers
+ *  and percent-encoding are taken into account.
+ * Useful to allocate the buffer for the expansion once or to fill size headers before the expansion is written.
+ *
+ * @param[in] uri_template A template to calculate expansion size for.
+ * @param[in] values Variables values to use for expansion.
+ *
+ * @returns Size of the expansion in characters.
+ */
+std::size_t ExpandedSize(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values);
+
+/**
+ * Calculates XXH64 hash of a string.
+ *
+ * @param[in] str A string to hash.
+ * @param[in] seed Hash seed.
+ *
+ * @returns 64-bit hash of @p str.
+ */
+std::uint64_t HashString(std::string_view str, std::uint64_t seed = 0);
+
+/**
+ * Calculates hash of uri-template expansion.
+ * Returns the same hash as HashString() of ExpandTemplate() result for the same arguments, but literals
+ *  and encoded values are hashed as they are produced, without building the expansion or allocating memory.
+ *
+ * @param[in] uri_template A template to calculate expansion hash for.
+ * @param[in] values Variables values to use for expansion.
+ * @param[in] seed Hash seed.
+ *
+ * @returns 64-bit hash of the expansion.
+ */
+std::uint64_t ExpansionHash(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                            std::uint64_t seed = 0);
+
+/**
+ * Checks if uri-template expansion is equal to @p uri.
+ * The same as comparing ExpandTemplate() result with @p uri, but the expansion is compared as it is produced,
+ *  without building it. Comparison stops at the first mismatching character.
+ *
+ * @param[in] uri_template A template to expand.
+ * @param[in] values Variables values to use for expansion.
+ * @param[in] uri A URI to compare the expansion with.
+ *
+ * @returns true if @p uri is the expansion of @p uri_template, false otherwise.
+ */
+bool ExpansionEquals(const Template& uri_template, const std::unordered_map<std::string, VarValue>& values,
+                     std::string_view uri);
+
 } // namespace Template
 } // namespace URI
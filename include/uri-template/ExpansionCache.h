@@ -0,0 +1,89 @@
+#pragma once
+
+#include "Expander.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace URI {
+namespace Template {
+
+/**
+ * Thread-safe bounded cache of expansion results.
+ * Entries are keyed by the identity (address) of a template and by the values of the variables it refers to,
+ *  other values in the map don't affect the key. Results are shared between callers and never modified.
+ * The cache is split into shards, each with its own lock and LRU list, so threads expanding different
+ *  templates or values rarely contend. Expansion itself runs outside of the lock.
+ * @note Templates are identified by address: a cached template should not be modified, or destroyed
+ *  while another one may be created at the same address, unless the cache is cleared.
+ */
+class ExpansionCache
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Capacity is divided between shards as evenly as possible, so the cache holds at most @p capacity results.
+     *  There are no more shards than @p capacity, so each shard keeps at least one entry.
+     *  A cache of zero capacity keeps nothing.
+     *
+     * @param[in] capacity Maximum number of cached results.
+     * @param[in] shards Number of shards, 1 makes a single global LRU.
+     *
+     * @throws std::invalid_argument if @p shards is 0.
+     */
+    explicit ExpansionCache(std::size_t capacity, std::size_t shards = 16);
+
+    /// Copy constructor.
+    ExpansionCache(const ExpansionCache&) = delete;
+    /// Copy assignment.
+    ExpansionCache& operator=(const ExpansionCache&) = delete;
+    /// Move constructor.
+    ExpansionCache(ExpansionCache&&) = delete;
+    /// Move assignment.
+    ExpansionCache& operator=(ExpansionCache&&) = delete;
+
+    /// Destructor.
+    ~ExpansionCache();
+
+    /**
+     * Expands the template or takes the result from the cache.
+     * The result is the same as of ExpandTemplate(). Variables which are not in @p values treated as undefined.
+     * On a miss the template is expanded and the result is stored, evicting the least recently used entry
+     *  of the shard if it's full.
+     *
+     * @param[in] uri_template A template to expand.
+     * @param[in] values Variables values to use for expansion.
+     *
+     * @returns Shared expansion result.
+     *
+     * @throws std::runtime_error if template has an empty expression.
+     */
+    std::shared_ptr<const std::string> Expand(const Template& uri_template,
+                                              const std::unordered_map<std::string, VarValue>& values);
+
+    /**
+     * Drops all cached results.
+     * Results already returned by Expand() stay valid. Counters are not reset.
+     */
+    void Clear();
+
+    /// Get the number of cached results.
+    std::size_t Size() const;
+
+    /// Get the number of Expand() calls which found the result in the cache.
+    std::uint64_t Hits() const;
+
+    /// Get the number of Expand() calls which had to expand the template.
+    std::uint64_t Misses() const;
+
+    /// Get the number of results dropped to free space for new ones.
+    std::uint64_t Evictions() const;
+
+private:
+    struct Shard;
+
+    std::vector<std::unique_ptr<Shard>> shards_; ///< Shards of the cache.
+};
+
+} // namespace Template
+} // namespace URI
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "ExpansionState.h"
+
+#include <iterator>
+
+namespace URI {
+namespace Template {
+
+/**
+ * Lazy range of expansions over the cartesian product of candidate values.
+ * Each axis is a variable with a list of candidate values. Combinations are enumerated in lexicographic order
+ *  of candidates positions, the last axis changes the fastest. Expansions are produced one by one into a single
+ *  buffer: moving to the next combination re-expands only the expressions of the variables which changed,
+ *  see ExpansionState.
+ * Range can be split into disjoint slices by combination index, e.g. to consume them in parallel.
+ * @note Product refers to the template, so the template should outlive it and its iterators.
+ */
+class ExpansionProduct
+{
+public:
+    /// Variable name and its candidate values.
+    using Axis = std::pair<std::string, std::vector<VarValue>>;
+
+    /**
+     * Input iterator over expansions of the product.
+     * Dereferencing gives the expansion of the current combination. The reference is valid until the iterator
+     *  is incremented or destroyed.
+     */
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag; // NOLINT(readability-identifier-naming)
+        using value_type = std::string; // NOLINT(readability-identifier-naming)
+        using difference_type = std::ptrdiff_t; // NOLINT(readability-identifier-naming)
+        using pointer = const std::string*; // NOLINT(readability-identifier-naming)
+        using reference = const std::string&; // NOLINT(readability-identifier-naming)
+
+        /// Get expansion of the current combination.
+        const std::string& operator*() const;
+
+        /// Get expansion of the current combination.
+        const std::string* operator->() const;
+
+        /// Moves to the next combination.
+        Iterator& operator++();
+
+        /// Compares positions of two iterators of the same product.
+        bool operator==(const Iterator& rhs) const;
+
+        /// Compares positions of two iterators of the same product.
+        bool operator!=(const Iterator& rhs) const;
+
+        /// Get index of the current combination.
+        std::size_t Index() const;
+
+        /**
+         * Get the current value of a variable.
+         *
+         * @param[in] name Name of the variable.
+         *
+         * @returns Pointer to the value or nullptr if there is no value of the variable.
+         */
+        const VarValue* Value(const std::string& name) const;
+
+    private:
+        friend class ExpansionProduct;
+
+        /// Creates iterator at combination @p index, which is past the last one if @p index is @p end.
+        Iterator(const ExpansionProduct& product, std::size_t index, std::size_t end);
+
+        const ExpansionProduct* product_; ///< Iterated product.
+        std::size_t index_; ///< Index of the current combination.
+        std::size_t end_; ///< Index past the last combination of the range.
+        std::vector<std::size_t> positions_; ///< Candidate position for each axis.
+        std::optional<ExpansionState> state_; ///< Expansion of the current combination.
+    };
+
+    /// Range of combinations of the product.
+    class Range
+    {
+    public:
+        /// Get iterator at the first combination of the range.
+        Iterator begin() const; // NOLINT(readability-identifier-naming)
+
+        /// Get iterator past the last combination of the range.
+        Iterator end() const; // NOLINT(readability-identifier-naming)
+
+        /// Get the number of combinations in the range.
+        std::size_t Size() const;
+
+    private:
+        friend class ExpansionProduct;
+
+        /// Creates range of combinations [@p first, @p last).
+        Range(const ExpansionProduct& product, std::size_t first, std::size_t last);
+
+        const ExpansionProduct* product_; ///< Iterated product.
+        std::size_t first_; ///< Index of the first combination.
+        std::size_t last_; ///< Index past the last combination.
+    };
+
+    /**
+     * Parametrized constructor.
+     *
+     * @param[in] uri_template A template to expand.
+     * @param[in] axes Variables with candidate values, the last one changes the fastest.
+     * @param[in] values Values of other variables, fixed for all combinations.
+     *
+     * @throws std::overflow_error if the number of combinations doesn't fit std::size_t.
+     */
+    ExpansionProduct(const Template& uri_template, std::vector<Axis> axes,
+                     std::unordered_map<std::string, VarValue> values = {});
+
+    /// Get the number of combinations.
+    std::size_t Size() const;
+
+    /// Get iterator at the first combination.
+    Iterator begin() const; // NOLINT(readability-identifier-naming)
+
+    /// Get iterator past the last combination.
+    Iterator end() const; // NOLINT(readability-identifier-naming)
+
+    /**
+     * Get a slice of the product.
+     * Slices with disjoint ranges of indexes may be iterated independently, e.g. in different threads.
+     *
+     * @param[in] first Index of the first combination.
+     * @param[in] last Index past the last combination, clamped to Size().
+     *
+     * @returns Range of combinations [@p first, @p last).
+     */
+    Range Slice(std::size_t first, std::size_t last) const;
+
+private:
+    const Template& uri_template_; ///< Template to expand.
+    std::vector<Axis> axes_; ///< Variables with candidate values.
+    std::unordered_map<std::string, VarValue> values_; ///< Fixed values.
+    std::size_t size_; ///< Number of combinations.
+};
+
+} // namespace Template
+} // namespace URI
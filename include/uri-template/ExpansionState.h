@@ -0,0 +1,71 @@
+#pragma once
+
+#include "Expander.h"
+
+namespace URI {
+namespace Template {
+
+/**
+ * Expansion result which is kept up to date with the values.
+ * State remembers where output of each expression starts and ends. Updating a variable re-expands only
+ *  the expressions which refer to it and splices their new output into the result, literals and other
+ *  expressions are not expanded again.
+ * Use it when a template is expanded many times with a few variables changing between expansions,
+ *  e.g. a page number or a cursor. The result is the same as of ExpandTemplate() over the current values.
+ * @note State refers to the template, so the template should outlive it and shouldn't be modified.
+ */
+class ExpansionState
+{
+public:
+    /**
+     * Parametrized constructor.
+     * Expands @p uri_template with @p values.
+     *
+     * @param[in] uri_template A template to expand.
+     * @param[in] values Variables values to use for expansion.
+     *
+     * @throws std::runtime_error if template has an empty expression.
+     */
+    ExpansionState(const Template& uri_template, std::unordered_map<std::string, VarValue> values);
+
+    /**
+     * Sets value of a variable and updates the result.
+     * Only expressions with variable @p name are expanded. Setting VarValue() makes the variable undefined.
+     *
+     * @param[in] name Name of the variable.
+     * @param[in] value New value of the variable.
+     */
+    void Update(const std::string& name, VarValue value);
+
+    /**
+     * Get the expansion result.
+     *
+     * @returns A const reference to expansion result over the current values.
+     */
+    const std::string& String() const;
+
+    /**
+     * Get the current values.
+     *
+     * @returns A const reference to the map of variables values.
+     */
+    const std::unordered_map<std::string, VarValue>& Values() const;
+
+private:
+    /// Output of a single expression in the result.
+    struct Segment
+    {
+        const Expression* expression; ///< Expression of the template.
+        std::size_t begin; ///< Start of the output in result_.
+        std::size_t size; ///< Size of the output.
+    };
+
+    std::unordered_map<std::string, VarValue> values_; ///< Current values.
+    std::vector<Segment> segments_; ///< Expressions outputs in order of the template.
+    std::unordered_map<std::string, std::vector<std::size_t>> dependents_; ///< Segments by variable names.
+    std::string result_; ///< Expansion result.
+    std::string scratch_; ///< Buffer for re-expanded expressions.
+};
+
+} // namespace Template
+} // namespace URI
@@ -2,6 +2,7 @@
 
 #include "Template.h"
 
+#include <memory_resource>
 #include <optional>
 
 namespace URI {
@@ -53,10 +54,13 @@ std::optional<Match> MatchLiteral(const Literal& literal, const std::string& whe
  * @param[in] var Variable definition to lookup value for.
  * @param[in] oper Template operator for @p var.
  * @param[in] where A string where to lookup for a match.
+ * @param[in] sort_keys If true then VarType::DICT value is sorted by keys, see VarDict::SortKeys().
+ *  Otherwise its items are in the order of @p where.
  *
  * @returns VarValue instance wrapped in std::optional or std::nullopt.
  */
-std::optional<VarValue> MatchVarValue(const Variable& var, const Operator& oper, std::optional<std::string>&& where);
+std::optional<VarValue> MatchVarValue(const Variable& var, const Operator& oper, std::optional<std::string>&& where,
+                                      bool sort_keys = false);
 
 /**
  * Lookup for template expression.
@@ -70,12 +74,14 @@ std::optional<VarValue> MatchVarValue(const Variable& var, const Operator& oper,
  * @param[in] terminator If this character met matching stops.
  * @param[out] values Map of template variables values found in the string.
  *  Not expanded variables will be filled with VarType::UNDEFINED.
+ * @param[in] sort_keys If dictionaries in @p values are sorted by keys, see MatchVarValue().
  *
  * @returns Match instance wrapped in std::optional or std::nullopt.
  */
 std::optional<Match> MatchExpression(const Expression& expression, const std::string& where, std::size_t start,
                                      std::size_t end, char terminator,
-                                     std::unordered_map<std::string, VarValue>* values = nullptr);
+                                     std::unordered_map<std::string, VarValue>* values = nullptr,
+                                     bool sort_keys = false);
 
 /**
  * Lookup for URI-template.
@@ -87,11 +93,61 @@ std::optional<Match> MatchExpression(const Expression& expression, const std::st
  * @param[in] uri An URI where to lookup for a match.
  * @param[out] values Map of template variables values found in the string.
  *  Not expanded variables will be filled with VarType::UNDEFINED.
+ * @param[in] sort_keys If dictionaries in @p values are sorted by keys, see MatchVarValue().
  *
  * @returns true if template matched, false – if not.
  */
 bool MatchURI(const Template& uri_template, const std::string& uri,
-              std::unordered_map<std::string, VarValue>* values = nullptr);
+              std::unordered_map<std::string, VarValue>* values = nullptr, bool sort_keys = false);
+
+/**
+ * Converts matched value to a native type.
+ * Parses VarType::STRING @p var_value as a number or a boolean ('true' or 'false'), the same way
+ *  they are formatted by the expansion. Undefined values and values of @p var_type are returned as is.
+ *
+ * @param[in] var_value A value to convert.
+ * @param[in] var_type Type to convert to.
+ *
+ * @returns Converted VarValue instance wrapped in std::optional or std::nullopt if conversion is not possible.
+ */
+std::optional<VarValue> ConvertVarValue(const VarValue& var_value, VarType var_type);
+
+/**
+ * Lookup for URI-template producing typed values.
+ * Same as MatchURI() above, but values of variables from @p var_types are converted to the requested types
+ *  with ConvertVarValue(). Template is not matched if any of the values cannot be converted.
+ *
+ * @param[in] uri_template Template to lookup for.
+ * @param[in] uri An URI where to lookup for a match.
+ * @param[in] var_types Types of the variables values, e.g. VarType::INT64 for ids.
+ * @param[out] values Map of template variables values found in the string.
+ *  Not expanded variables will be filled with VarType::UNDEFINED.
+ * @param[in] sort_keys If dictionaries in @p values are sorted by keys, see MatchVarValue().
+ *
+ * @returns true if template matched, false – if not.
+ */
+bool MatchURI(const Template& uri_template, const std::string& uri,
+              const std::unordered_map<std::string, VarType>& var_types,
+              std::unordered_map<std::string, VarValue>* values = nullptr, bool sort_keys = false);
+
+/**
+ * Lookup for URI-template producing values in a memory resource.
+ * Same as MatchURI() above, but the values are matched within the memory resource of @p values,
+ *  so the results may live in a per-request arena and be released together with it.
+ *  The @p uri is copied into the memory resource once and values are views of the copy. Temporary containers
+ *  of the matching are allocated from the memory resource too, so the matching doesn't use the heap.
+ * Values views are valid while the memory resource of @p values is alive.
+ *
+ * @param[in] uri_template Template to lookup for.
+ * @param[in] uri An URI where to lookup for a match.
+ * @param[out] values Map of template variables values views found in the string.
+ *  Not expanded variables will be filled with VarType::UNDEFINED.
+ * @param[in] sort_keys If dictionaries in @p values are sorted by keys, see MatchVarValue().
+ *
+ * @returns true if template matched, false – if not.
+ */
+bool MatchURI(const Template& uri_template, const std::string& uri,
+              std::pmr::unordered_map<std::string_view, VarValueView>& values, bool sort_keys = false);
 
 } // namespace Template
 } // namespace URI
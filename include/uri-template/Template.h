@@ -3,6 +3,11 @@
 #include "Operator.h"
 #include "Variable.h"
 
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace URI {
 namespace Template {
 
@@ -263,7 +268,9 @@ public:
     template <class... Args>
     Part& EmplaceBack(Args&&... args)
     {
-        return parts_.emplace_back(std::forward<Args>(args)...);
+        Part& part = parts_.emplace_back(std::forward<Args>(args)...);
+        IndexVariables(part);
+        return part;
     }
 
     /**
@@ -282,6 +289,8 @@ public:
 
     /**
      * Get a vector of parts in the template.
+     * @note Parts may be changed through the reference, so VariableIndex() and VariableNames() walk the template
+     *  until the next EmplaceBack() call.
      *
      * @returns A reference to vector of parts.
      */
@@ -297,6 +306,7 @@ public:
     /**
      * Get specific part of the template by its index.
      * @note Accessing a nonexistent element through this operator is undefined behavior.
+     * @note The part may be changed through the reference, see Parts().
      *
      * @param[in] pos Index of the part to return.
      *
@@ -317,8 +327,35 @@ public:
     /// Get the template string.
     std::string String() const noexcept;
 
+    /**
+     * Get names of the variables in the template.
+     * Each name is listed once, in order of its first appearance in the template.
+     * Position of the name in the list is the slot of the variable, see VariableIndex().
+     *
+     * @returns A vector of variables names.
+     */
+    std::vector<std::string> VariableNames() const;
+
+    /**
+     * Get the slot of a variable.
+     * Variables are numbered in order of their first appearance in the template, starting from 0.
+     * Variables with the same name share the same slot.
+     * Slots are looked up in a table, which is kept by EmplaceBack().
+     *
+     * @param[in] name Name of the variable.
+     *
+     * @returns Slot of the variable wrapped in std::optional or std::nullopt if the template doesn't have it.
+     */
+    std::optional<std::size_t> VariableIndex(const std::string& name) const;
+
 private:
+    /// Adds variables of the new @p part to the table of slots, or rebuilds the table if parts were changed.
+    void IndexVariables(const Part& part);
+
     std::vector<Part> parts_; ///< Collection of parts.
+    std::vector<std::string> variable_names_; ///< Variables names by slots.
+    std::unordered_map<std::string, std::size_t> variable_slots_; ///< Slots of the variables by names.
+    bool variables_indexed_ = true; ///< If the table of slots is up to date, i.e. parts weren't changed in place.
 };
 
 } // namespace Template
@@ -2,9 +2,14 @@
 
 #include "Modifier.h"
 
+#include <cstdint>
+#include <deque>
+#include <initializer_list>
 #include <memory>
 #include <ostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <unordered_set>
 #include <variant>
@@ -17,23 +22,157 @@ namespace Template {
  * Variable value type enumerator.
  * Describes type of the variable in the template.
  */
-enum class VarType
+enum class VarType : std::uint8_t
 {
     UNDEFINED, /**< value is not defined */
     STRING, /**< value is a string */
     LIST, /**< value is a list of strings */
     DICT, /**< value is an associative dictionary of strings */
+    INT64, /**< value is a signed integer */
+    UINT64, /**< value is an unsigned integer */
+    DOUBLE, /**< value is a floating-point number */
+    BOOL, /**< value is a boolean */
+};
+
+/// Checks if @p T is an arithmetic type which can be held by a value natively. Characters are excluded.
+template <class T>
+constexpr bool kIsNativeNumber = std::is_arithmetic<T>::value && !std::is_same<T, char>::value;
+
+/**
+ * Dictionary of strings held by VarType::DICT values.
+ * Items are stored in the order of insertion, so the expansion of the same dictionary
+ *  always produces the same string. Use SortKeys() to get the canonical order regardless of how
+ *  the dictionary was filled.
+ * Lookup by key is linear for dictionaries of a typical size, which is cheaper than hashing. Larger dictionaries
+ *  keep an index of key hashes, so lookups stay constant-time for dictionaries filled from untrusted input.
+ * Keys are const, same as in std::map, so only values may be changed through iterators.
+ */
+class VarDict
+{
+public:
+    using value_type = std::pair<const std::string, std::string>; ///< Key/value pair.
+    using iterator = std::deque<value_type>::iterator; ///< Iterator.
+    using const_iterator = std::deque<value_type>::const_iterator; ///< Const iterator.
+
+    /// Constructor. Creates an empty dictionary.
+    VarDict() = default;
+
+    /**
+     * Parametrized constructor.
+     * Creates a dictionary of @p items in their order. Only the first of items with equal keys is kept.
+     *
+     * @param[in] items Key/value pairs.
+     */
+    VarDict(std::initializer_list<value_type> items);
+
+    /**
+     * Parametrized constructor.
+     * Creates a dictionary of @p dict items. Items are sorted by keys, since @p dict doesn't have an order.
+     *
+     * @param[in] dict Key/value pairs.
+     */
+    explicit VarDict(const std::unordered_map<std::string, std::string>& dict);
+
+    /// Get the first item.
+    const_iterator begin() const; // NOLINT(readability-identifier-naming)
+    /// Get past the last item.
+    const_iterator end() const; // NOLINT(readability-identifier-naming)
+    /// Get the first item.
+    iterator begin(); // NOLINT(readability-identifier-naming)
+    /// Get past the last item.
+    iterator end(); // NOLINT(readability-identifier-naming)
+
+    /// Get number of items.
+    std::size_t size() const; // NOLINT(readability-identifier-naming)
+    /// Check if the dictionary is empty.
+    bool empty() const; // NOLINT(readability-identifier-naming)
+    /// Reserve space for the index of @p size items.
+    void reserve(std::size_t size); // NOLINT(readability-identifier-naming)
+
+    /// Find an item by @p key. Returns end() if there is no such item.
+    const_iterator find(std::string_view key) const; // NOLINT(readability-identifier-naming)
+    /// Find an item by @p key. Returns end() if there is no such item.
+    iterator find(std::string_view key); // NOLINT(readability-identifier-naming)
+    /// Get number of items with @p key, either 0 or 1.
+    std::size_t count(std::string_view key) const; // NOLINT(readability-identifier-naming)
+
+    /**
+     * Get value by @p key.
+     *
+     * @throws std::out_of_range if there is no such item.
+     */
+    const std::string& at(std::string_view key) const; // NOLINT(readability-identifier-naming)
+
+    /// Get value by @p key, appending an item with an empty value if there is no such item.
+    std::string& operator[](std::string_view key);
+
+    /**
+     * Append an item if there is no item with the same @p key.
+     *
+     * @returns Iterator to the item with @p key and true if the item was appended.
+     */
+    std::pair<iterator, bool> emplace(std::string key, std::string value); // NOLINT(readability-identifier-naming)
+
+    /**
+     * Append an item or replace value of the item with the same @p key. Order of the items is kept.
+     *
+     * @returns Iterator to the item with @p key and true if the item was appended.
+     */
+    std::pair<iterator, bool> insert_or_assign(std::string key, // NOLINT(readability-identifier-naming)
+                                               std::string value);
+
+    /**
+     * Append an item without looking for an item with the same @p key.
+     * Use it to fill a dictionary from keys which are known to be unique.
+     */
+    void AppendUnique(std::string key, std::string value);
+
+    /// Remove item with @p key, keeping the order of others. Returns number of removed items.
+    std::size_t erase(std::string_view key); // NOLINT(readability-identifier-naming)
+
+    /// Sort items by keys, which gives canonical order to the dictionary.
+    void SortKeys();
+
+    /// Compares two dictionaries. Dictionaries are equal if they have the same items in any order.
+    bool operator==(const VarDict& rhs) const;
+    /// Compares two dictionaries.
+    bool operator!=(const VarDict& rhs) const;
+
+private:
+    /// Dictionaries up to this size are searched linearly and have no index.
+    static constexpr std::size_t kIndexThreshold = 16;
+
+    /// Get position of the item with @p key or size() if there is no such item.
+    std::size_t Position(std::string_view key) const;
+    /// Appends an item with a key known to be unique.
+    iterator Append(std::string&& key, std::string&& value);
+    /// Rebuilds the index after items are moved.
+    void Reindex();
+
+    // deque doesn't move items when it grows, since items with const keys can only be copied
+    std::deque<value_type> items_; ///< Items in order.
+    std::unordered_multimap<std::size_t, std::size_t> index_; ///< Positions of items by key hashes, if large.
 };
 
 /**
  * URI-template variable value.
  * This class represent type-safe union for value instances.
  * The value can hold either std::string or std::vector<std::string> or
- *  std::unordered_map<std::string, std::string> instance.
+ *  VarDict instance, or a number or a boolean.
+ * Numbers and booleans are formatted during expansion without intermediate strings.
+ *
+ * The value is a tagged union with a single type designator. Strings are stored inline and use small-string
+ *  optimization of std::string, so short strings don't allocate. Lists and dictionaries are rarely used compared
+ *  to strings, so they are stored out of line and the value doesn't pay for their size.
+ *  sizeof(VarValue) is sizeof(std::string) + 8, i.e. 40 bytes with libstdc++ and 32 bytes with libc++
+ *  on 64-bit platforms.
  */
 class VarValue
 {
 public:
+    /// Representation of dictionaries before VarDict, see Get().
+    using LegacyDict = std::unordered_map<std::string, std::string>;
+
     /**
      * Parametrized constructor.
      * Creates an empty variable value of desired type.
@@ -62,21 +201,56 @@ public:
      * Parametrized constructor.
      * Creates a VarType::DICT variable from a @p dict_value.
      *
+     * @param[in] dict_value VarDict to hold as value.
+     */
+    VarValue(VarDict&& dict_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a VarType::DICT variable from a @p dict_value. Items are sorted by keys, see VarDict.
+     *
      * @param[in] dict_value std::unordered_map to hold as value.
      */
     VarValue(std::unordered_map<std::string, std::string>&& dict_value);
 
+    /**
+     * Parametrized constructor.
+     * Creates a VarType::BOOL variable from a boolean, VarType::DOUBLE from a floating-point number,
+     *  VarType::INT64 from a signed integer and VarType::UINT64 from an unsigned integer @p num_value.
+     *
+     * @tparam T Type of the number.
+     *
+     * @param[in] num_value A number to hold as value.
+     */
+    template <class T, typename = std::enable_if_t<kIsNativeNumber<T>>>
+    VarValue(T num_value)
+    {
+        if constexpr (std::is_same<T, bool>::value) {
+            type_ = VarType::BOOL;
+            storage_.boolean = num_value;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            type_ = VarType::DOUBLE;
+            storage_.number = static_cast<double>(num_value);
+        } else if constexpr (std::is_signed<T>::value) {
+            type_ = VarType::INT64;
+            storage_.int64 = static_cast<std::int64_t>(num_value);
+        } else {
+            type_ = VarType::UINT64;
+            storage_.uint64 = static_cast<std::uint64_t>(num_value);
+        }
+    }
+
     /// Copy constructor.
-    VarValue(const VarValue&) = default;
+    VarValue(const VarValue& other);
     /// Copy assignment.
-    VarValue& operator=(const VarValue&) = default;
+    VarValue& operator=(const VarValue& other);
     /// Move constructor.
-    VarValue(VarValue&&) noexcept = default;
+    VarValue(VarValue&& other) noexcept;
     /// Move assignment.
-    VarValue& operator=(VarValue&&) noexcept = default;
+    VarValue& operator=(VarValue&& other) noexcept;
 
     /// Destructor.
-    ~VarValue() = default;
+    ~VarValue();
 
     /**
      * Get specific representation.
@@ -84,15 +258,16 @@ public:
      * @tparam T Type of the representation to get. Either:
      * @li `std::string` or
      * @li `std::vector<std::string>` or
-     * @li `std::unordered_map<std::string, std::string>`
+     * @li `VarDict` or
+     * @li `std::int64_t`, `std::uint64_t`, `double`, `bool`
      *
      * @returns A reference of @p T to stored value.
      * @throws std::bad_variant_access if type mismatch.
      */
-    template <class T>
+    template <class T, std::enable_if_t<!std::is_same<T, LegacyDict>::value, int> = 0>
     T& Get()
     {
-        return std::get<T>(value_);
+        return const_cast<T&>(static_cast<const VarValue&>(*this).Get<T>());
     }
 
     /**
@@ -101,20 +276,72 @@ public:
      * @tparam T Type of the representation to get. Either:
      * @li `std::string` or
      * @li `std::vector<std::string>` or
-     * @li `std::unordered_map<std::string, std::string>`
+     * @li `VarDict` or
+     * @li `std::int64_t`, `std::uint64_t`, `double`, `bool`
      *
      * @returns A const reference of @p T to stored value.
      * @throws std::bad_variant_access if type mismatch.
      */
-    template <class T>
+    template <class T, std::enable_if_t<!std::is_same<T, LegacyDict>::value, int> = 0>
     const T& Get() const
     {
-        return std::get<T>(value_);
+        if constexpr (std::is_same<T, std::string>::value) {
+            CheckType(VarType::STRING);
+            return storage_.string;
+        } else if constexpr (std::is_same<T, std::vector<std::string>>::value) {
+            CheckType(VarType::LIST);
+            return *storage_.list;
+        } else if constexpr (std::is_same<T, VarDict>::value) {
+            CheckType(VarType::DICT);
+            return *storage_.dict;
+        } else if constexpr (std::is_same<T, std::int64_t>::value) {
+            CheckType(VarType::INT64);
+            return storage_.int64;
+        } else if constexpr (std::is_same<T, std::uint64_t>::value) {
+            CheckType(VarType::UINT64);
+            return storage_.uint64;
+        } else if constexpr (std::is_same<T, double>::value) {
+            CheckType(VarType::DOUBLE);
+            return storage_.number;
+        } else {
+            static_assert(std::is_same<T, bool>::value, "VarValue doesn't hold this type");
+            CheckType(VarType::BOOL);
+            return storage_.boolean;
+        }
+    }
+
+    /**
+     * Get a copy of the dictionary as std::unordered_map, the representation of dictionaries before VarDict.
+     *
+     * @tparam T `std::unordered_map<std::string, std::string>`.
+     *
+     * @returns A copy of the dictionary.
+     * @throws std::bad_variant_access if the value is not a dictionary.
+     */
+    template <class T, std::enable_if_t<std::is_same<T, LegacyDict>::value, int> = 0>
+    [[deprecated("use Get<VarDict>()")]] LegacyDict Get() const
+    {
+        CheckType(VarType::DICT);
+        return LegacyDict(storage_.dict->begin(), storage_.dict->end());
     }
 
     /// Get type of the value.
     VarType Type() const;
 
+    /**
+     * Mark the value as pre-encoded.
+     * Pre-encoded value is trusted to have only characters allowed by the expression operator
+     *  (unreserved, reserved for '+' and '#' operators, and percent-encoded triplets), so the expansion copies it
+     *  verbatim instead of percent-encoding. Use it for UUIDs, identifiers or values encoded upstream.
+     * Debug builds assert that the value is really safe for the operator.
+     *
+     * @param[in] pre_encoded If the value is pre-encoded.
+     */
+    void SetPreEncoded(bool pre_encoded = true);
+
+    /// Check if the value is pre-encoded.
+    bool IsPreEncoded() const;
+
     /**
      * Produce printable value image.
      * Stored value printed as follows:
@@ -122,6 +349,8 @@ public:
      *  @li VarType::STRING -> string
      *  @li VarType::LIST -> ['string', 'string', ...]
      *  @li VarType::DICT -> {'key': 'value', 'key': 'value', ...}
+     *  @li VarType::INT64, VarType::UINT64, VarType::DOUBLE -> number
+     *  @li VarType::BOOL -> true or false
      * Where 'undefined' is literal constant, and 'string', 'key', 'value'
      *  are contents of vector or unordered_map respectively.
      *
@@ -129,19 +358,47 @@ public:
      */
     std::string Print() const;
 
-    /// Compares two values.
+    /// Compares two values. Pre-encoded mark is not compared.
     bool operator==(const VarValue& rhs) const;
     /// Compares two values.
     bool operator!=(const VarValue& rhs) const;
 
 private:
-    VarType type_; ///< Type designator.
-    // clang-format off
-    std::variant<std::monostate,
-                 std::string,
-                 std::vector<std::string>,
-                 std::unordered_map<std::string, std::string>> value_;  ///< Value internal storage.
-    // clang-format on
+    /// Value storage. The active member is defined by the type designator.
+    union Storage
+    {
+        /// Constructor. Members are constructed by VarValue.
+        Storage() {}
+        /// Destructor. Members are destroyed by VarValue.
+        ~Storage() {}
+
+        std::string string; ///< VarType::STRING value.
+        std::vector<std::string>* list; ///< Owned VarType::LIST value.
+        VarDict* dict; ///< Owned VarType::DICT value.
+        std::int64_t int64; ///< VarType::INT64 value.
+        std::uint64_t uint64; ///< VarType::UINT64 value.
+        double number; ///< VarType::DOUBLE value.
+        bool boolean; ///< VarType::BOOL value.
+    };
+
+    /// Throws std::bad_variant_access if the value is not of @p var_type.
+    void CheckType(VarType var_type) const
+    {
+        if (type_ != var_type) {
+            throw std::bad_variant_access();
+        }
+    }
+
+    /// Copies value of @p other into the destroyed storage.
+    void CopyFrom(const VarValue& other);
+    /// Moves value of @p other into the destroyed storage, leaving @p other undefined.
+    void MoveFrom(VarValue& other) noexcept;
+    /// Destroys the active member of the storage.
+    void Destroy() noexcept;
+
+    Storage storage_; ///< Value internal storage.
+    VarType type_ = VarType::UNDEFINED; ///< Type designator.
+    bool pre_encoded_ = false; ///< If the value is copied without percent-encoding.
 };
 
 /// VarValue printer via std::ostream's operator<<.
@@ -151,6 +408,216 @@ inline std::ostream& operator<<(std::ostream& os, const VarValue& var_value)
     return os;
 }
 
+/**
+ * Non-owning view of a contiguous array.
+ * Minimal replacement of std::span to refer to composite values.
+ *
+ * @tparam T Type of the array elements.
+ */
+template <class T>
+class ArrayView
+{
+public:
+    /// Constructor. Creates an empty view.
+    ArrayView() = default;
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of @p size elements starting from @p data.
+     */
+    ArrayView(const T* data, std::size_t size)
+        : data_(data)
+        , size_(size)
+    {
+    }
+
+    /// Parametrized constructor. Creates a view of @p vector.
+    ArrayView(const std::vector<T>& vector)
+        : ArrayView(vector.data(), vector.size())
+    {
+    }
+
+    /// Get the first element.
+    const T* begin() const // NOLINT(readability-identifier-naming)
+    {
+        return data_;
+    }
+
+    /// Get past the last element.
+    const T* end() const // NOLINT(readability-identifier-naming)
+    {
+        return data_ + size_;
+    }
+
+    /// Get a reference to the first element. Calling it on empty view is undefined behavior.
+    const T& front() const // NOLINT(readability-identifier-naming)
+    {
+        return *data_;
+    }
+
+    /// Get number of elements.
+    std::size_t size() const // NOLINT(readability-identifier-naming)
+    {
+        return size_;
+    }
+
+    /// Check if the view is empty.
+    bool empty() const // NOLINT(readability-identifier-naming)
+    {
+        return size_ == 0;
+    }
+
+    /// Get element by index. Accessing a nonexistent element is undefined behavior.
+    const T& operator[](std::size_t pos) const
+    {
+        return data_[pos];
+    }
+
+private:
+    const T* data_ = nullptr; ///< The first element.
+    std::size_t size_ = 0; ///< Number of elements.
+};
+
+/**
+ * Non-owning URI-template variable value.
+ * This class represent type-safe union for views of values, stored elsewhere. The value can hold either
+ *  std::string_view or a view of std::string_view array or a view of array of key/value pairs of std::string_view.
+ * Numbers and booleans are held by value, same as in VarValue.
+ * Allows to expand values from request buffers, arenas or other storage without copying them into VarValue.
+ * @note VarValueView doesn't own the data, so the data should outlive the view.
+ */
+class VarValueView
+{
+public:
+    /// Key/value pair of a dictionary.
+    using DictItem = std::pair<std::string_view, std::string_view>;
+    /// View of list items.
+    using List = ArrayView<std::string_view>;
+    /// View of dictionary items.
+    using Dict = ArrayView<DictItem>;
+
+    /**
+     * Constructor.
+     * Creates a view of VarType::UNDEFINED value.
+     */
+    VarValueView() = default;
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::STRING value @p str_value.
+     *
+     * @param[in] str_value A string to view.
+     */
+    VarValueView(std::string_view str_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::STRING value @p str_value.
+     *
+     * @param[in] str_value Null-terminated string to view.
+     */
+    VarValueView(const char* str_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::STRING value @p str_value.
+     *
+     * @param[in] str_value A string to view.
+     */
+    VarValueView(const std::string& str_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::LIST value @p list_value.
+     *
+     * @param[in] list_value List items to view.
+     */
+    VarValueView(List list_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::LIST value @p list_value.
+     *
+     * @param[in] list_value List items to view.
+     */
+    VarValueView(const std::vector<std::string_view>& list_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::DICT value @p dict_value.
+     *
+     * @param[in] dict_value Dictionary items to view.
+     */
+    VarValueView(Dict dict_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a view of VarType::DICT value @p dict_value.
+     *
+     * @param[in] dict_value Dictionary items to view.
+     */
+    VarValueView(const std::vector<DictItem>& dict_value);
+
+    /**
+     * Parametrized constructor.
+     * Creates a number or a boolean value, see VarValue::VarValue(T).
+     *
+     * @tparam T Type of the number.
+     *
+     * @param[in] num_value A number to hold.
+     */
+    template <class T, typename = std::enable_if_t<kIsNativeNumber<T>>>
+    VarValueView(T num_value)
+    {
+        if constexpr (std::is_same<T, bool>::value) {
+            type_ = VarType::BOOL;
+            value_ = num_value;
+        } else if constexpr (std::is_floating_point<T>::value) {
+            type_ = VarType::DOUBLE;
+            value_ = static_cast<double>(num_value);
+        } else if constexpr (std::is_signed<T>::value) {
+            type_ = VarType::INT64;
+            value_ = static_cast<std::int64_t>(num_value);
+        } else {
+            type_ = VarType::UINT64;
+            value_ = static_cast<std::uint64_t>(num_value);
+        }
+    }
+
+    /**
+     * Get specific representation.
+     *
+     * @tparam T Type of the representation to get. Either:
+     * @li `std::string_view` or
+     * @li `VarValueView::List` or
+     * @li `VarValueView::Dict` or
+     * @li `std::int64_t`, `std::uint64_t`, `double`, `bool`
+     *
+     * @returns A copy of @p T view.
+     * @throws std::bad_variant_access if type mismatch.
+     */
+    template <class T>
+    T Get() const
+    {
+        return std::get<T>(value_);
+    }
+
+    /// Get type of the value.
+    VarType Type() const;
+
+    /// Mark the value as pre-encoded, see VarValue::SetPreEncoded().
+    void SetPreEncoded(bool pre_encoded = true);
+
+    /// Check if the value is pre-encoded.
+    bool IsPreEncoded() const;
+
+private:
+    VarType type_ = VarType::UNDEFINED; ///< Type designator.
+    bool pre_encoded_ = false; ///< If the value is copied without percent-encoding.
+    std::variant<std::monostate, std::string_view, List, Dict, std::int64_t, std::uint64_t, double, bool>
+        value_; ///< Viewed value.
+};
+
 /**
  * URI-template variable definition.
  * This class represent a variable defined in the template.
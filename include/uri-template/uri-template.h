@@ -1,5 +1,9 @@
 #pragma once
 
+#include <uri-template/CompiledExpander.h>
 #include <uri-template/Expander.h>
+#include <uri-template/ExpansionCache.h>
+#include <uri-template/ExpansionProduct.h>
+#include <uri-template/ExpansionState.h>
 #include <uri-template/Matcher.h>
 #include <uri-template/Parser.h>
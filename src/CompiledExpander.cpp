@@ -0,0 +1,228 @@
+#include "uri-template/CompiledExpander.h"
+
+#include "Expansion.h"
+
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+URI::Template::CompiledExpander::CompiledExpander(const Template& uri_template)
+    : names_(uri_template.VariableNames())
+{
+    for (std::size_t i = 0; i < names_.size(); ++i) {
+        slots_.emplace(names_[i], i);
+    }
+
+    for (const auto& part : uri_template.Parts()) {
+        switch (part.Type()) {
+        case PartType::LITERAL: {
+            const auto& literal = part.Get<Literal>().String();
+            if (literal.empty()) {
+                break;
+            }
+            if (!instructions_.empty() && instructions_.back().code == OpCode::LITERAL) {
+                // merge with the previous literal, they are adjacent in literals_
+                instructions_.back().end += literal.size();
+            } else {
+                instructions_.push_back({OpCode::LITERAL, Operator::kNoCharacter, Operator::kNoCharacter, false, false,
+                                         false, literals_.size(), literals_.size() + literal.size()});
+            }
+            literals_ += literal;
+        } break;
+
+        case PartType::EXPRESSION: {
+            const auto& expression = part.Get<Expression>();
+            if (expression.Vars().empty()) {
+                throw std::runtime_error("expression is empty");
+            }
+
+            const auto oper = detail::MakeOperatorSpec(expression.Oper());
+            const std::size_t begin = variables_.size();
+            for (const auto& var : expression.Vars()) {
+                variables_.push_back(
+                    {var.Name(), var.IsPrefixed(), var.IsExploded(), var.Length(), slots_.at(var.Name())});
+            }
+            instructions_.push_back({OpCode::EXPRESSION, oper.first, oper.separator, oper.named, oper.empty_eq,
+                                     oper.reserved, begin, variables_.size()});
+        } break;
+        }
+    }
+}
+
+template <class Sink, class Lookup>
+void URI::Template::CompiledExpander::ExpandTo(Lookup&& lookup, Sink& sink) const
+{
+    for (const auto& instruction : instructions_) {
+        switch (instruction.code) {
+        case OpCode::LITERAL:
+            sink.append(literals_.data() + instruction.begin, instruction.end - instruction.begin);
+            break;
+
+        case OpCode::EXPRESSION: {
+            const detail::OperatorSpec oper = {instruction.first, instruction.separator, instruction.named,
+                                               instruction.empty_eq, instruction.reserved};
+            detail::ExpressionWriter<Sink> writer(oper, sink);
+            for (std::size_t i = instruction.begin; i < instruction.end; ++i) {
+                const auto& var = variables_[i];
+                const auto* var_value = lookup(var);
+                if (var_value != nullptr) {
+                    writer.Write({var.name, var.prefixed, var.exploded, var.length}, *var_value);
+                }
+            }
+        } break;
+        }
+    }
+}
+
+namespace {
+
+/// Creates lookup for CompiledExpander::ExpandTo() over the bound values.
+auto SlotLookup(URI::Template::BoundValues values)
+{
+    return [values](const auto& var) { return values.Find(var.slot); };
+}
+
+} // namespace
+
+std::string URI::Template::CompiledExpander::Expand(const std::unordered_map<std::string, VarValue>& values) const
+{
+    std::string result;
+    Expand(values, result);
+    return result;
+}
+
+void URI::Template::CompiledExpander::Expand(const std::unordered_map<std::string, VarValue>& values,
+                                             std::string& result) const
+{
+    if (result.empty()) {
+        result.reserve(literals_.size());
+    }
+    ExpandTo(detail::MapLookup(values), result);
+}
+
+void URI::Template::CompiledExpander::Expand(const std::unordered_map<std::string, VarValue>& values,
+                                             OutputSink sink) const
+{
+    ExpandTo(detail::MapLookup(values), sink);
+}
+
+std::string URI::Template::CompiledExpander::Expand(BoundValues values) const
+{
+    std::string result;
+    Expand(values, result);
+    return result;
+}
+
+void URI::Template::CompiledExpander::Expand(BoundValues values, std::string& result) const
+{
+    if (result.empty()) {
+        result.reserve(literals_.size());
+    }
+    ExpandTo(SlotLookup(values), result);
+}
+
+void URI::Template::CompiledExpander::Expand(BoundValues values, OutputSink sink) const
+{
+    ExpandTo(SlotLookup(values), sink);
+}
+
+URI::Template::ExpandedBatch URI::Template::CompiledExpander::ExpandBatch(
+    const std::unordered_map<std::string, BoundValues>& columns, std::size_t threads) const
+{
+    // columns by slots, so rows are expanded without looking up variables by names
+    std::vector<BoundValues> slot_columns(names_.size(), BoundValues(nullptr, 0));
+    std::size_t rows = 0;
+    for (std::size_t slot = 0; slot < names_.size(); ++slot) {
+        const auto column = columns.find(names_[slot]);
+        if (column != columns.end()) {
+            slot_columns[slot] = column->second;
+            rows = std::max(rows, column->second.Size());
+        }
+    }
+
+    // expands rows [begin, end) appending to the buffer and offsets past the end of each row
+    const auto expand_rows = [this, &slot_columns](std::size_t begin, std::size_t end, std::string& buffer,
+                                                   std::size_t* offsets) {
+        buffer.reserve(buffer.size() + (end - begin) * literals_.size());
+        for (std::size_t row = begin; row < end; ++row) {
+            ExpandTo([&slot_columns, row](const VariableInfo& var) { return slot_columns[var.slot].Find(row); },
+                     buffer);
+            *offsets++ = buffer.size();
+        }
+    };
+
+    ExpandedBatch batch;
+    batch.offsets.resize(rows + 1, 0);
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, std::max<std::size_t>(rows, 1));
+    if (threads == 1) {
+        expand_rows(0, rows, batch.buffer, batch.offsets.data() + 1);
+        return batch;
+    }
+
+    // each thread expands a contiguous range of rows into its own buffer, buffers are concatenated afterwards
+    std::vector<std::string> buffers(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    const auto range_begin = [rows, threads](std::size_t i) { return rows * i / threads; };
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&, i] {
+            try {
+                expand_rows(range_begin(i), range_begin(i + 1), buffers[i], batch.offsets.data() + range_begin(i) + 1);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    std::size_t size = 0;
+    for (const auto& buffer : buffers) {
+        size += buffer.size();
+    }
+    batch.buffer.reserve(size);
+    for (std::size_t i = 0; i < threads; ++i) {
+        const std::size_t shift = batch.buffer.size();
+        for (std::size_t row = range_begin(i); row < range_begin(i + 1); ++row) {
+            batch.offsets[row + 1] += shift;
+        }
+        batch.buffer += buffers[i];
+    }
+    return batch;
+}
+
+const std::vector<std::string>& URI::Template::CompiledExpander::VariableNames() const
+{
+    return names_;
+}
+
+std::optional<std::size_t> URI::Template::CompiledExpander::VariableIndex(const std::string& name) const
+{
+    const auto it = slots_.find(name);
+    if (it == slots_.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::size_t URI::Template::CompiledExpander::LiteralSize() const
+{
+    return literals_.size();
+}
+
+URI::Template::ExpandedBatch URI::Template::ExpandBatch(const Template& uri_template,
+                                                       const std::unordered_map<std::string, BoundValues>& columns,
+                                                       std::size_t threads)
+{
+    return CompiledExpander(uri_template).ExpandBatch(columns, threads);
+}
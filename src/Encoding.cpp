@@ -0,0 +1,171 @@
+#include "Encoding.h"
+
+#ifdef URITEMPLATE_X86_64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define URITEMPLATE_TARGET_AVX2
+#else
+#define URITEMPLATE_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+std::size_t URI::Template::detail::CleanPrefixScalar(const char* data, std::size_t size, bool allow_reserved)
+{
+    const CharTable& allowed = allow_reserved ? kReservedTable : kUnreservedTable;
+
+    std::size_t i = 0;
+    while (i < size && allowed[static_cast<unsigned char>(data[i])]) {
+        ++i;
+    }
+    return i;
+}
+
+#ifdef URITEMPLATE_X86_64
+
+namespace {
+
+/*
+ * Both kernels classify characters with signed byte comparisons, so everything above 0x7F
+ *  is negative and falls out of the checked ranges.
+ *
+ * unreserved: (c | 0x20) in ['a', 'z'] / c in ['-', '9'] except '/' / '_' / '~'
+ * reserved:   c in ['!', '~'] except '"' / '%' / '<' / '>' / '\' / '^' / '`' / '{' / '|' / '}'
+ */
+
+inline __m128i InRange(__m128i v, char lo, char hi)
+{
+    return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(static_cast<char>(lo - 1))),
+                         _mm_cmplt_epi8(v, _mm_set1_epi8(static_cast<char>(hi + 1))));
+}
+
+inline __m128i Equal(__m128i v, char c)
+{
+    return _mm_cmpeq_epi8(v, _mm_set1_epi8(c));
+}
+
+inline __m128i CleanMask(__m128i v, bool allow_reserved)
+{
+    if (allow_reserved) {
+        __m128i excluded = _mm_or_si128(Equal(v, '"'), Equal(v, '%'));
+        excluded = _mm_or_si128(excluded, _mm_or_si128(Equal(v, '<'), Equal(v, '>')));
+        excluded = _mm_or_si128(excluded, _mm_or_si128(Equal(v, '\\'), Equal(v, '^')));
+        excluded = _mm_or_si128(excluded, _mm_or_si128(Equal(v, '`'), Equal(v, '{')));
+        excluded = _mm_or_si128(excluded, _mm_or_si128(Equal(v, '|'), Equal(v, '}')));
+        return _mm_andnot_si128(excluded, InRange(v, '!', '~'));
+    }
+    const __m128i alpha = InRange(_mm_or_si128(v, _mm_set1_epi8(0x20)), 'a', 'z');
+    const __m128i digit = _mm_andnot_si128(Equal(v, '/'), InRange(v, '-', '9'));
+    const __m128i other = _mm_or_si128(Equal(v, '_'), Equal(v, '~'));
+    return _mm_or_si128(_mm_or_si128(alpha, digit), other);
+}
+
+URITEMPLATE_TARGET_AVX2 inline __m256i InRange(__m256i v, char lo, char hi)
+{
+    return _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(static_cast<char>(lo - 1))),
+                            _mm256_cmpgt_epi8(_mm256_set1_epi8(static_cast<char>(hi + 1)), v));
+}
+
+URITEMPLATE_TARGET_AVX2 inline __m256i Equal(__m256i v, char c)
+{
+    return _mm256_cmpeq_epi8(v, _mm256_set1_epi8(c));
+}
+
+URITEMPLATE_TARGET_AVX2 inline __m256i CleanMask(__m256i v, bool allow_reserved)
+{
+    if (allow_reserved) {
+        __m256i excluded = _mm256_or_si256(Equal(v, '"'), Equal(v, '%'));
+        excluded = _mm256_or_si256(excluded, _mm256_or_si256(Equal(v, '<'), Equal(v, '>')));
+        excluded = _mm256_or_si256(excluded, _mm256_or_si256(Equal(v, '\\'), Equal(v, '^')));
+        excluded = _mm256_or_si256(excluded, _mm256_or_si256(Equal(v, '`'), Equal(v, '{')));
+        excluded = _mm256_or_si256(excluded, _mm256_or_si256(Equal(v, '|'), Equal(v, '}')));
+        return _mm256_andnot_si256(excluded, InRange(v, '!', '~'));
+    }
+    const __m256i alpha = InRange(_mm256_or_si256(v, _mm256_set1_epi8(0x20)), 'a', 'z');
+    const __m256i digit = _mm256_andnot_si256(Equal(v, '/'), InRange(v, '-', '9'));
+    const __m256i other = _mm256_or_si256(Equal(v, '_'), Equal(v, '~'));
+    return _mm256_or_si256(_mm256_or_si256(alpha, digit), other);
+}
+
+inline unsigned CountTrailingZeros(unsigned mask)
+{
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#endif
+}
+
+} // namespace
+
+std::size_t URI::Template::detail::CleanPrefixSse2(const char* data, std::size_t size, bool allow_reserved)
+{
+    std::size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const auto mask = static_cast<unsigned>(_mm_movemask_epi8(CleanMask(v, allow_reserved)));
+        if (mask != 0xFFFF) {
+            return i + CountTrailingZeros(~mask);
+        }
+    }
+    return i + CleanPrefixScalar(data + i, size - i, allow_reserved);
+}
+
+URITEMPLATE_TARGET_AVX2 std::size_t URI::Template::detail::CleanPrefixAvx2(const char* data, std::size_t size,
+                                                                          bool allow_reserved)
+{
+    std::size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const auto mask = static_cast<unsigned>(_mm256_movemask_epi8(CleanMask(v, allow_reserved)));
+        if (mask != 0xFFFFFFFF) {
+            return i + CountTrailingZeros(~mask);
+        }
+    }
+    return i + CleanPrefixSse2(data + i, size - i, allow_reserved);
+}
+
+bool URI::Template::detail::HasAvx2()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    const bool osxsave = (info[2] & (1 << 27)) != 0;
+    const bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+std::size_t URI::Template::detail::CleanPrefix(const char* data, std::size_t size, bool allow_reserved)
+{
+    // short values are not worth a call through the pointer
+    if (size < 16) {
+        return CleanPrefixScalar(data, size, allow_reserved);
+    }
+
+    static const CleanPrefixFn kernel = []() -> CleanPrefixFn {
+#ifdef URITEMPLATE_X86_64
+        if (HasAvx2()) {
+            return CleanPrefixAvx2;
+        }
+        return CleanPrefixSse2;
+#else
+        return CleanPrefixScalar;
+#endif
+    }();
+    return kernel(data, size, allow_reserved);
+}
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string_view>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define URITEMPLATE_X86_64 1
+#endif
+
+namespace URI {
+namespace Template {
+namespace detail { // NOLINT(readability-identifier-naming)
+
+/// Character classification table indexed by unsigned char.
+using CharTable = std::array<bool, 256>;
+
+/*
+ * RFC6570:
+ *      unreserved = ALPHA / DIGIT / "-" / "." / "_" / "~"
+ *      reserved   = gen-delims / sub-delims
+ *
+ * Mirrors Variable::kValueChars (without "%" and ",", which are not allowed to be copied as is)
+ *  and Variable::kReservedChars.
+ */
+inline constexpr std::string_view kUnreservedChars =
+    "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-._~";
+inline constexpr std::string_view kReservedChars = ":/?#[]@!$&'()*+,;=";
+inline constexpr std::string_view kHexChars = "0123456789abcdefABCDEF";
+inline constexpr char kHexDigits[] = "0123456789ABCDEF";
+
+constexpr CharTable MakeCharTable(std::string_view first, std::string_view second = std::string_view())
+{
+    CharTable table = {};
+    for (char c : first) {
+        table[static_cast<unsigned char>(c)] = true;
+    }
+    for (char c : second) {
+        table[static_cast<unsigned char>(c)] = true;
+    }
+    return table;
+}
+
+inline constexpr CharTable kUnreservedTable = MakeCharTable(kUnreservedChars);
+inline constexpr CharTable kReservedTable = MakeCharTable(kUnreservedChars, kReservedChars);
+inline constexpr CharTable kHexTable = MakeCharTable(kHexChars);
+
+/**
+ * Signature of a kernel which looks up for the first character of [data, data + size) that
+ *  can't be copied as is by percent-encoding, i.e. either should be encoded or is a '%'.
+ *
+ * @returns Length of the prefix which can be copied as is.
+ */
+using CleanPrefixFn = std::size_t (*)(const char* data, std::size_t size, bool allow_reserved);
+
+/// Portable kernel, checks one character at a time.
+std::size_t CleanPrefixScalar(const char* data, std::size_t size, bool allow_reserved);
+
+#ifdef URITEMPLATE_X86_64
+/// SSE2 kernel, checks 16 characters at a time.
+std::size_t CleanPrefixSse2(const char* data, std::size_t size, bool allow_reserved);
+/// AVX2 kernel, checks 32 characters at a time. Must be called only if HasAvx2() is true.
+std::size_t CleanPrefixAvx2(const char* data, std::size_t size, bool allow_reserved);
+/// Check if CPU and OS support AVX2 instructions.
+bool HasAvx2();
+#endif
+
+/// Kernel selected once for the running CPU.
+std::size_t CleanPrefix(const char* data, std::size_t size, bool allow_reserved);
+
+/// Max length of a run of characters copied as is, which a stoppable walk scans before reporting it.
+inline constexpr std::size_t kWalkChunkSize = 4096;
+
+/**
+ * Walks through the @p value the way percent-encoding does.
+ * Calls @p on_copy(begin, end) for every run of characters which are copied as is
+ *  and @p on_escape(c) for every character which should be percent-encoded.
+ * Already encoded triplets are copied and counted as single character against @p max_len.
+ *
+ * If the callbacks return bool, the walk stops once one of them returns false. Long runs are reported
+ *  in pieces of at most kWalkChunkSize characters then, so the rest of a long value isn't scanned after the stop.
+ */
+template <class OnCopy, class OnEscape>
+void WalkPctEncode(std::string_view value, bool allow_reserved, std::size_t max_len, OnCopy&& on_copy,
+                   OnEscape&& on_escape)
+{
+    constexpr bool kStoppable = std::is_same_v<std::invoke_result_t<OnCopy&, std::size_t, std::size_t>, bool>;
+    static_assert(kStoppable == std::is_same_v<std::invoke_result_t<OnEscape&, unsigned char>, bool>,
+                  "both callbacks should either return bool or not");
+
+    if (max_len > value.size()) {
+        max_len = value.size();
+    }
+
+    std::size_t run_start = 0;
+    std::size_t i = 0;
+    while (i < max_len) {
+        if constexpr (kStoppable) {
+            const std::size_t end = std::min(max_len, i + kWalkChunkSize);
+            i += CleanPrefix(value.data() + i, end - i, allow_reserved);
+            if (i == end && i < max_len) {
+                if (!on_copy(run_start, i)) {
+                    return;
+                }
+                run_start = i;
+                continue;
+            }
+        } else {
+            i += CleanPrefix(value.data() + i, max_len - i, allow_reserved);
+        }
+        if (i >= max_len) {
+            break;
+        }
+
+        const auto c = static_cast<unsigned char>(value[i]);
+        if (c == '%' && i + 2 < max_len && kHexTable[static_cast<unsigned char>(value[i + 1])] &&
+            kHexTable[static_cast<unsigned char>(value[i + 2])]) {
+            // already encoded triplets count as one character
+            if (max_len + 2 <= value.size()) {
+                max_len += 2;
+            }
+            ++i;
+            continue;
+        }
+        // Any other characters are percent-encoded
+        if constexpr (kStoppable) {
+            if (!on_copy(run_start, i) || !on_escape(c)) {
+                return;
+            }
+        } else {
+            on_copy(run_start, i);
+            on_escape(c);
+        }
+        run_start = ++i;
+    }
+    on_copy(run_start, max_len);
+}
+
+/// Checks if percent-encoding leaves @p value unchanged, i.e. the value is safe to be copied as is.
+inline bool IsPctEncoded(std::string_view value, bool allow_reserved)
+{
+    bool escaped = false;
+    WalkPctEncode(
+        value, allow_reserved, value.size(), [](std::size_t, std::size_t) {},
+        [&escaped](unsigned char) { escaped = true; });
+    return !escaped;
+}
+
+} // namespace detail
+} // namespace Template
+} // namespace URI
@@ -1,161 +1,493 @@
 #include "uri-template/Expander.h"
 
-#include <iomanip>
-#include <sstream>
+#include "Expansion.h"
+#include "Hash.h"
 
-std::string URI::Template::PctEncode(const std::string& value, bool allow_reserved, std::size_t max_len)
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef __unix__
+#include <sys/uio.h>
+
+static_assert(sizeof(URI::Template::ExpansionSegment) == sizeof(iovec) &&
+                  offsetof(URI::Template::ExpansionSegment, data) == offsetof(iovec, iov_base) &&
+                  offsetof(URI::Template::ExpansionSegment, size) == offsetof(iovec, iov_len),
+              "ExpansionSegment should have the layout of iovec");
+#endif
+
+namespace {
+
+/// Get shared instance of the operator of @p type.
+std::shared_ptr<URI::Template::Operator> SharedOperator(URI::Template::OperatorType type)
 {
-    std::ostringstream encoded;
-    encoded.fill('0');
-    encoded << std::hex;
-    if (max_len > value.size()) {
-        max_len = value.size();
+    for (const auto& oper : URI::Template::KNOWN_OPERATORS) {
+        if (oper->Type() == type) {
+            return oper;
+        }
     }
+    return URI::Template::NOOP_OPERATOR;
+}
 
-    for (std::size_t i = 0; i < max_len; ++i) {
-        const auto& c = value[i];
-        if (c == '%' && i + 2 < max_len && std::isxdigit(value[i + 1]) && std::isxdigit(value[i + 2])) {
-            encoded << c;
-            // already encoded triplets count as one character
-            if (max_len + 2 <= value.size()) {
-                max_len += 2;
-            }
-            continue;
-        }
-        if (c != '%' && c != ',' && URI::Template::Variable::kValueChars.count(c)) {
-            encoded << c;
-            continue;
-        }
-        if (allow_reserved && URI::Template::Variable::kReservedChars.count(c)) {
-            encoded << c;
+/**
+ * Appends expansion of @p variables with @p oper to the @p literal.
+ * Characters which are not allowed in literals, e.g. "'" of reserved expansion, are percent-encoded,
+ *  so the literal is parsed back the same.
+ */
+void AppendBound(std::string& literal, const std::shared_ptr<URI::Template::Operator>& oper,
+                 std::vector<URI::Template::Variable> variables,
+                 const std::unordered_map<std::string, URI::Template::VarValue>& values)
+{
+    const std::string expanded =
+        URI::Template::ExpandExpression(URI::Template::Expression(std::shared_ptr(oper), std::move(variables)), values);
+    for (const char c : expanded) {
+        if (URI::Template::Literal::kNotAllowedChars.count(c) == 0) {
+            literal += c;
             continue;
         }
-        // Any other characters are percent-encoded
-        encoded << std::uppercase;
-        encoded << '%' << std::setw(2) << int((unsigned char)c);
-        encoded << std::nouppercase;
+        const auto code = static_cast<unsigned char>(c);
+        literal += '%';
+        literal += URI::Template::detail::kHexDigits[code >> 4];
+        literal += URI::Template::detail::kHexDigits[code & 0x0F];
+    }
+}
+
+} // namespace
+
+std::string URI::Template::PctEncode(const std::string& value, bool allow_reserved, std::size_t max_len)
+{
+    std::string encoded;
+    PctEncode(value, encoded, allow_reserved, max_len);
+    return encoded;
+}
+
+void URI::Template::PctEncode(std::string_view value, std::string& result, bool allow_reserved, std::size_t max_len)
+{
+    std::size_t copied = 0;
+    std::size_t escaped = 0;
+    detail::WalkPctEncode(
+        value, allow_reserved, max_len, [&copied](std::size_t begin, std::size_t end) { copied += end - begin; },
+        [&escaped](unsigned char) { ++escaped; });
+
+    if (escaped == 0) {
+        // nothing to encode, copy as is
+        result.append(value.data(), copied);
+        return;
     }
 
-    return encoded.str();
+    const std::size_t offset = result.size();
+    result.resize(offset + copied + escaped * 3);
+    char* out = &result[offset];
+    detail::WalkPctEncode(
+        value, allow_reserved, max_len,
+        [&out, &value](std::size_t begin, std::size_t end) {
+            std::memcpy(out, value.data() + begin, end - begin);
+            out += end - begin;
+        },
+        [&out](unsigned char c) {
+            *out++ = '%';
+            *out++ = detail::kHexDigits[c >> 4];
+            *out++ = detail::kHexDigits[c & 0x0F];
+        });
 }
 
 std::string URI::Template::ExpandExpression(const URI::Template::Expression& expression,
                                             const std::unordered_map<std::string, URI::Template::VarValue>& values)
 {
     std::string result;
-    const Operator& oper = expression.Oper();
-    const std::vector<Variable>& variables = expression.Vars();
+    ExpandExpression(expression, values, result);
+    return result;
+}
+
+void URI::Template::ExpandExpression(const Expression& expression,
+                                     const std::unordered_map<std::string, VarValue>& values, std::string& result)
+{
+    detail::ExpandExpressionTo(expression, detail::MapLookup(values), result);
+}
+
+void URI::Template::ExpandExpression(const Expression& expression,
+                                     const std::unordered_map<std::string, VarValue>& values, OutputSink sink)
+{
+    detail::ExpandExpressionTo(expression, detail::MapLookup(values), sink);
+}
 
-    if (variables.empty()) {
-        throw std::runtime_error("expression is empty");
+std::string URI::Template::ExpandTemplate(const URI::Template::Template& uri_template,
+                                          const std::unordered_map<std::string, URI::Template::VarValue>& values)
+{
+    std::string result;
+    ExpandTemplate(uri_template, values, result);
+    return result;
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::unordered_map<std::string, VarValue>& values, std::string& result)
+{
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), result);
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::unordered_map<std::string, VarValue>& values, OutputSink sink)
+{
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+}
+
+URI::Template::ExpansionStatus URI::Template::ExpandTemplate(
+    const Template& uri_template, const std::unordered_map<std::string, VarValue>& values, std::string& result,
+    std::size_t max_output_bytes)
+{
+    const std::size_t size = result.size();
+    detail::LimitedSink sink(result, max_output_bytes);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    if (sink.Stopped()) {
+        result.resize(size);
+        return ExpansionStatus::OUTPUT_LIMIT_EXCEEDED;
     }
+    return ExpansionStatus::OK;
+}
 
-    bool first = true;
-    auto expand_variable = [&first, &oper](const std::string& name, const std::string& value, int length, bool named,
-                                           bool encode) {
-        std::string result;
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::unordered_map<std::string, VarValue>& values, ScatteredExpansion& result)
+{
+    detail::ScatterSink sink(result);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    sink.Finish();
+}
 
-        if (first) {
-            first = false;
-            if (oper.First() != Operator::kNoCharacter) {
-                result += oper.First();
-            }
-        } else {
-            result += oper.Separator();
-        }
+URI::Template::ScatteredExpansion::ScatteredExpansion(const ScatteredExpansion& other)
+    : segments_(other.segments_)
+    , scratch_offsets_(other.scratch_offsets_)
+    , scratch_(other.scratch_)
+    , size_(other.size_)
+{
+    RebaseScratch();
+}
 
-        if (named) {
-            result += name;
+URI::Template::ScatteredExpansion::ScatteredExpansion(ScatteredExpansion&& other) noexcept
+    : segments_(std::move(other.segments_))
+    , scratch_offsets_(std::move(other.scratch_offsets_))
+    , scratch_(std::move(other.scratch_))
+    , size_(std::exchange(other.size_, 0))
+{
+    // short scratch buffer may be stored inside the string and move to another address
+    RebaseScratch();
+}
 
-            if (!value.empty() || oper.EmptyEq()) {
-                result += '=';
-            }
-        }
+URI::Template::ScatteredExpansion& URI::Template::ScatteredExpansion::operator=(const ScatteredExpansion& other)
+{
+    if (this != &other) {
+        segments_ = other.segments_;
+        scratch_offsets_ = other.scratch_offsets_;
+        scratch_ = other.scratch_;
+        size_ = other.size_;
+        RebaseScratch();
+    }
+    return *this;
+}
 
-        if (length >= 0) {
-            result += encode ? PctEncode(value, oper.Reserved(), length) : value.substr(0, length);
-        } else {
-            result += encode ? PctEncode(value, oper.Reserved()) : value;
+URI::Template::ScatteredExpansion& URI::Template::ScatteredExpansion::operator=(ScatteredExpansion&& other) noexcept
+{
+    if (this != &other) {
+        segments_ = std::move(other.segments_);
+        scratch_offsets_ = std::move(other.scratch_offsets_);
+        scratch_ = std::move(other.scratch_);
+        size_ = std::exchange(other.size_, 0);
+        RebaseScratch();
+    }
+    return *this;
+}
+
+void URI::Template::ScatteredExpansion::RebaseScratch()
+{
+    for (std::size_t i = 0; i < segments_.size(); ++i) {
+        if (scratch_offsets_[i] != kLiteralOffset) {
+            segments_[i].data = scratch_.data() + scratch_offsets_[i];
         }
+    }
+}
+
+URI::Template::ExpandIntoResult URI::Template::ExpandInto(const Template& uri_template,
+                                                          const std::unordered_map<std::string, VarValue>& values,
+                                                          char* buffer, std::size_t capacity)
+{
+    detail::BufferSink sink(buffer, capacity);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    return {sink.Fits() ? ExpansionStatus::OK : ExpansionStatus::TRUNCATED, sink.Size()};
+}
+
+URI::Template::ExpandIntoResult URI::Template::ExpandInto(
+    const Template& uri_template, const std::unordered_map<std::string_view, VarValueView>& values, char* buffer,
+    std::size_t capacity)
+{
+    detail::BufferSink sink(buffer, capacity);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    return {sink.Fits() ? ExpansionStatus::OK : ExpansionStatus::TRUNCATED, sink.Size()};
+}
+
+std::string URI::Template::ExpandExpression(const Expression& expression,
+                                            const std::unordered_map<std::string_view, VarValueView>& values)
+{
+    std::string result;
+    ExpandExpression(expression, values, result);
+    return result;
+}
+
+void URI::Template::ExpandExpression(const Expression& expression,
+                                     const std::unordered_map<std::string_view, VarValueView>& values,
+                                     std::string& result)
+{
+    detail::ExpandExpressionTo(expression, detail::MapLookup(values), result);
+}
+
+void URI::Template::ExpandExpression(const Expression& expression,
+                                     const std::unordered_map<std::string_view, VarValueView>& values, OutputSink sink)
+{
+    detail::ExpandExpressionTo(expression, detail::MapLookup(values), sink);
+}
+
+std::string URI::Template::ExpandTemplate(const Template& uri_template,
+                                          const std::unordered_map<std::string_view, VarValueView>& values)
+{
+    std::string result;
+    ExpandTemplate(uri_template, values, result);
+    return result;
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::unordered_map<std::string_view, VarValueView>& values,
+                                   std::string& result)
+{
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), result);
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::unordered_map<std::string_view, VarValueView>& values, OutputSink sink)
+{
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+}
+
+std::string URI::Template::ExpandExpression(const Expression& expression, ValueResolver resolver)
+{
+    std::string result;
+    ExpandExpression(expression, resolver, result);
+    return result;
+}
+
+void URI::Template::ExpandExpression(const Expression& expression, ValueResolver resolver, std::string& result)
+{
+    detail::ExpandExpressionTo(expression, detail::ResolverLookup(resolver), result);
+}
+
+void URI::Template::ExpandExpression(const Expression& expression, ValueResolver resolver, OutputSink sink)
+{
+    detail::ExpandExpressionTo(expression, detail::ResolverLookup(resolver), sink);
+}
 
-        return result;
+std::string URI::Template::ExpandTemplate(const Template& uri_template, ValueResolver resolver)
+{
+    std::string result;
+    ExpandTemplate(uri_template, resolver, result);
+    return result;
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template, ValueResolver resolver, std::string& result)
+{
+    detail::ExpandTemplateTo(uri_template, detail::ResolverLookup(resolver), result);
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template, ValueResolver resolver, OutputSink sink)
+{
+    detail::ExpandTemplateTo(uri_template, detail::ResolverLookup(resolver), sink);
+}
+
+std::string URI::Template::ExpandExpression(const Expression& expression, const ValueScope& scope)
+{
+    std::string result;
+    ExpandExpression(expression, scope, result);
+    return result;
+}
+
+void URI::Template::ExpandExpression(const Expression& expression, const ValueScope& scope, std::string& result)
+{
+    detail::ExpandExpressionTo(expression, detail::ScopeLookup(scope), result);
+}
+
+void URI::Template::ExpandExpression(const Expression& expression, const ValueScope& scope, OutputSink sink)
+{
+    detail::ExpandExpressionTo(expression, detail::ScopeLookup(scope), sink);
+}
+
+std::string URI::Template::ExpandTemplate(const Template& uri_template, const ValueScope& scope)
+{
+    std::string result;
+    ExpandTemplate(uri_template, scope, result);
+    return result;
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template, const ValueScope& scope, std::string& result)
+{
+    detail::ExpandTemplateTo(uri_template, detail::ScopeLookup(scope), result);
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template, const ValueScope& scope, OutputSink sink)
+{
+    detail::ExpandTemplateTo(uri_template, detail::ScopeLookup(scope), sink);
+}
+
+std::pmr::string URI::Template::ExpandTemplate(const Template& uri_template,
+                                               const std::unordered_map<std::string, VarValue>& values,
+                                               std::pmr::memory_resource* resource)
+{
+    std::pmr::string result(resource);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), result);
+    return result;
+}
+
+std::pmr::string URI::Template::ExpandTemplate(const Template& uri_template,
+                                               const std::pmr::unordered_map<std::string_view, VarValueView>& values,
+                                               std::pmr::memory_resource* resource)
+{
+    std::pmr::string result(resource != nullptr ? resource : values.get_allocator().resource());
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), result);
+    return result;
+}
+
+void URI::Template::ExpandTemplate(const Template& uri_template,
+                                   const std::pmr::unordered_map<std::string_view, VarValueView>& values,
+                                   std::pmr::string& result)
+{
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), result);
+}
+
+URI::Template::Template URI::Template::BindPartial(const Template& uri_template,
+                                                   const std::unordered_map<std::string, VarValue>& values)
+{
+    Template result;
+    std::string literal;
+    const auto flush_literal = [&result, &literal]() {
+        if (!literal.empty()) {
+            result.EmplaceBack(Literal(std::move(literal)));
+            literal.clear();
+        }
     };
 
-    const auto undefined_value = VarValue(VarType::UNDEFINED);
-    for (const Variable& var : variables) {
-        const std::string& var_name = var.Name();
-        const Modifier& var_modifier = var.Mod();
+    for (const auto& part : uri_template.Parts()) {
+        if (part.Type() == PartType::LITERAL) {
+            literal += part.Get<Literal>().String();
+            continue;
+        }
 
-        const VarValue* var_value = &undefined_value;
-        const auto value_lookup = values.find(var_name);
-        if (value_lookup != values.end()) {
-            var_value = &value_lookup->second;
+        const auto& expression = part.Get<Expression>();
+        if (expression.Vars().empty()) {
+            throw std::runtime_error("expression is empty");
+        }
+        // undefined bound variables expand to nothing, so they are just dropped
+        std::vector<Variable> variables;
+        std::size_t bound_count = 0;
+        for (const auto& var : expression.Vars()) {
+            const auto value_lookup = values.find(var.Name());
+            if (value_lookup == values.end()) {
+                variables.push_back(var);
+            } else if (value_lookup->second.Type() != VarType::UNDEFINED) {
+                variables.push_back(var);
+                ++bound_count;
+            }
         }
+        const auto is_bound = [&values](const Variable& var) { return values.count(var.Name()) != 0; };
 
-        switch (var_value->Type()) {
-        case VarType::UNDEFINED:
-            break;
-        case VarType::STRING:
-            result += expand_variable(var_name, var_value->Get<std::string>(),
-                                      var_modifier.Type() == ModifierType::LENGTH ? var.Length() : -1, oper.Named(),
-                                      true);
-            break;
-        case VarType::LIST:
-            if (var_modifier.Type() == ModifierType::EXPLODE) {
-                for (const auto& list_item : var_value->Get<std::vector<std::string>>()) {
-                    result += expand_variable(var_name, list_item, -1, oper.Named(), true);
-                }
-            } else {
-                bool first_item = true;
-                std::string join_value;
-                for (const auto& list_item : var_value->Get<std::vector<std::string>>()) {
-                    if (!first_item) {
-                        join_value += ',';
-                    }
-                    join_value += PctEncode(list_item, oper.Reserved());
-                    first_item = false;
-                }
-                result += expand_variable(var_name, join_value, -1, oper.Named(), false);
+        auto oper = SharedOperator(expression.Oper().Type());
+        if (bound_count == variables.size()) {
+            if (!variables.empty()) {
+                AppendBound(literal, oper, std::move(variables), values);
+            }
+            continue;
+        }
+        if (bound_count == 0) {
+            flush_literal();
+            result.EmplaceBack(Expression(std::move(oper), std::move(variables)));
+            continue;
+        }
+
+        // partly bound expression is split into runs of bound and unbound variables,
+        //  which is possible only if every item is prefixed the same way
+        auto run_begin = variables.begin();
+        switch (expression.Oper().Type()) {
+        case OperatorType::QUERY: {
+            // "?" is put before the first item only, so bound variables must come before unbound ones,
+            //  unless the bound prefix puts it, e.g. it isn't made of empty lists only
+            if (!is_bound(variables.front())) {
+                throw std::invalid_argument("query expression '" + expression.String() +
+                                            "' can't be bound after an unbound variable");
+            }
+            run_begin = std::find_if_not(variables.begin(), variables.end(), is_bound);
+            std::string prefix;
+            AppendBound(prefix, oper, std::vector<Variable>(variables.begin(), run_begin), values);
+            if (!prefix.empty()) {
+                literal += prefix;
+                oper = SharedOperator(OperatorType::QUERY_CONTINUE);
+            } else if (std::any_of(run_begin, variables.end(), is_bound)) {
+                throw std::invalid_argument("query expression '" + expression.String() +
+                                            "' can't be bound after an unbound variable");
             }
+        } break;
+
+        case OperatorType::LABEL:
+        case OperatorType::PATH:
+        case OperatorType::PATH_PARAMETER:
+        case OperatorType::QUERY_CONTINUE:
             break;
-        case VarType::DICT:
-            if (var_modifier.Type() == ModifierType::EXPLODE) {
-                for (const auto& [name, val] : var_value->Get<std::unordered_map<std::string, std::string>>()) {
-                    result += expand_variable(PctEncode(name, oper.Reserved()), val, -1, true, true);
-                }
+
+        case OperatorType::NONE:
+        case OperatorType::RESERVED_CHARS:
+        case OperatorType::FRAGMENT:
+            throw std::invalid_argument("expression '" + expression.String() + "' can't be bound partially");
+        }
+        while (run_begin != variables.end()) {
+            const bool bound = is_bound(*run_begin);
+            const auto run_end = std::find_if(run_begin, variables.end(),
+                                              [&is_bound, bound](const Variable& var) { return is_bound(var) != bound; });
+            std::vector<Variable> run(run_begin, run_end);
+            if (bound) {
+                AppendBound(literal, oper, std::move(run), values);
             } else {
-                bool first_item = true;
-                std::string join_value;
-                for (const auto& [name, val] : var_value->Get<std::unordered_map<std::string, std::string>>()) {
-                    if (!first_item) {
-                        join_value += ',';
-                    }
-                    join_value += PctEncode(name, oper.Reserved()) + "," + PctEncode(val, oper.Reserved());
-                    first_item = false;
-                }
-                result += expand_variable(var_name, join_value, -1, oper.Named(), false);
+                flush_literal();
+                result.EmplaceBack(Expression(std::shared_ptr(oper), std::move(run)));
             }
-            break;
+            run_begin = run_end;
         }
     }
-
+    flush_literal();
     return result;
 }
 
-std::string URI::Template::ExpandTemplate(const URI::Template::Template& uri_template,
-                                          const std::unordered_map<std::string, URI::Template::VarValue>& values)
+std::size_t URI::Template::ExpandedSize(const Template& uri_template,
+                                        const std::unordered_map<std::string, VarValue>& values)
 {
-    std::string result;
+    detail::CountingSink sink;
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    return sink.Size();
+}
 
-    for (const auto& part : uri_template.Parts()) {
-        switch (part.Type()) {
-        case PartType::LITERAL:
-            result += part.Get<Literal>().String();
-            break;
-        case PartType::EXPRESSION:
-            result += ExpandExpression(part.Get<Expression>(), values);
-        }
-    }
+std::uint64_t URI::Template::HashString(std::string_view str, std::uint64_t seed)
+{
+    detail::HashSink sink(seed);
+    sink.append(str.data(), str.size());
+    return sink.Digest();
+}
 
-    return result;
+std::uint64_t URI::Template::ExpansionHash(const Template& uri_template,
+                                           const std::unordered_map<std::string, VarValue>& values, std::uint64_t seed)
+{
+    detail::HashSink sink(seed);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    return sink.Digest();
+}
+
+bool URI::Template::ExpansionEquals(const Template& uri_template,
+                                    const std::unordered_map<std::string, VarValue>& values, std::string_view uri)
+{
+    detail::ComparingSink sink(uri);
+    detail::ExpandTemplateTo(uri_template, detail::MapLookup(values), sink);
+    return sink.Equal();
 }
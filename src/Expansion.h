@@ -0,0 +1,824 @@
+#pragma once
+
+#include "Encoding.h"
+#include "uri-template/Expander.h"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace URI {
+namespace Template {
+namespace detail { // NOLINT(readability-identifier-naming)
+
+/**
+ * Sink which doesn't store anything, but counts the number of characters appended to it.
+ */
+class CountingSink
+{
+public:
+    /// Counts @p size characters.
+    void append(const char*, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        size_ += size;
+    }
+
+    /// Counts a single character.
+    void push_back(char) // NOLINT(readability-identifier-naming)
+    {
+        ++size_;
+    }
+
+    /// Get the number of characters appended.
+    std::size_t Size() const
+    {
+        return size_;
+    }
+
+private:
+    std::size_t size_ = 0; ///< Number of characters appended.
+};
+
+/**
+ * Sink which compares characters appended to it with the expected string instead of storing them.
+ * After the first mismatch the rest of the output is ignored and the sink reports it's stopped.
+ */
+class ComparingSink
+{
+public:
+    /// Parametrized constructor.
+    explicit ComparingSink(std::string_view expected)
+        : expected_(expected)
+    {
+    }
+
+    /// Compares @p size characters with the expected ones.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        if (mismatch_) {
+            return;
+        }
+        if (size > expected_.size() - pos_ || std::memcmp(expected_.data() + pos_, data, size) != 0) {
+            mismatch_ = true;
+            return;
+        }
+        pos_ += size;
+    }
+
+    /// Compares a single character with the expected one.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        if (mismatch_) {
+            return;
+        }
+        if (pos_ == expected_.size() || expected_[pos_] != c) {
+            mismatch_ = true;
+            return;
+        }
+        ++pos_;
+    }
+
+    /// Check if there was a mismatch, so further output doesn't matter.
+    bool Stopped() const
+    {
+        return mismatch_;
+    }
+
+    /// Get the number of expected characters which are not matched yet.
+    std::size_t Remaining() const
+    {
+        return expected_.size() - pos_;
+    }
+
+    /// Marks the output as different from the expected one, e.g. when it's known to be too long.
+    void Mismatch()
+    {
+        mismatch_ = true;
+    }
+
+    /// Check if the output is equal to the expected string.
+    bool Equal() const
+    {
+        return !mismatch_ && pos_ == expected_.size();
+    }
+
+private:
+    std::string_view expected_; ///< Expected output.
+    std::size_t pos_ = 0; ///< Number of characters matched.
+    bool mismatch_ = false; ///< If the output differs from the expected one.
+};
+
+/// Checks if @p Sink can stop, i.e. has `bool Stopped() const` method.
+template <class Sink, class = void>
+struct CanStop : std::false_type
+{
+};
+
+/// Specialization for sinks which can stop.
+template <class Sink>
+struct CanStop<Sink, std::void_t<decltype(std::declval<const Sink&>().Stopped())>> : std::true_type
+{
+};
+
+/**
+ * Checks if @p sink doesn't need more output, so expansion may stop early.
+ * Sinks which can stop have `bool Stopped() const` method, others never stop.
+ */
+template <class Sink>
+bool IsStopped(const Sink& sink)
+{
+    if constexpr (CanStop<Sink>::value) {
+        return sink.Stopped();
+    } else {
+        return false;
+    }
+}
+
+/**
+ * Percent-encodes @p value into @p sink.
+ * Copies runs of allowed characters with a single append() call. Sinks which can stop get long runs
+ *  in pieces, and encoding stops in the middle of the value once the sink is stopped.
+ */
+template <class Sink>
+void EncodeTo(Sink& sink, std::string_view value, bool allow_reserved,
+              std::size_t max_len = std::numeric_limits<std::size_t>::max())
+{
+    const auto copy = [&sink, &value](std::size_t begin, std::size_t end) {
+        if (begin != end) {
+            sink.append(value.data() + begin, end - begin);
+        }
+    };
+    const auto escape = [&sink](unsigned char c) {
+        const char triplet[3] = {'%', kHexDigits[c >> 4], kHexDigits[c & 0x0F]};
+        sink.append(triplet, sizeof(triplet));
+    };
+    if constexpr (CanStop<Sink>::value) {
+        WalkPctEncode(
+            value, allow_reserved, max_len,
+            [&sink, &copy](std::size_t begin, std::size_t end) {
+                copy(begin, end);
+                return !sink.Stopped();
+            },
+            [&sink, &escape](unsigned char c) {
+                escape(c);
+                return !sink.Stopped();
+            });
+    } else {
+        WalkPctEncode(value, allow_reserved, max_len, copy, escape);
+    }
+}
+
+/**
+ * Percent-encodes @p value into the comparing sink.
+ * Every character of @p value makes at least one character of the output, so a value longer than the rest
+ *  of the expected string is a mismatch without encoding.
+ */
+inline void EncodeTo(ComparingSink& sink, std::string_view value, bool allow_reserved,
+                     std::size_t max_len = std::numeric_limits<std::size_t>::max())
+{
+    if (sink.Stopped()) {
+        return;
+    }
+    if (std::min(value.size(), max_len) > sink.Remaining()) {
+        sink.Mismatch();
+        return;
+    }
+    EncodeTo<ComparingSink>(sink, value, allow_reserved, max_len);
+}
+
+/// Percent-encodes @p value into std::string, growing it at most once.
+inline void EncodeTo(std::string& sink, std::string_view value, bool allow_reserved,
+                     std::size_t max_len = std::numeric_limits<std::size_t>::max())
+{
+    PctEncode(value, sink, allow_reserved, max_len);
+}
+
+/**
+ * Sink which writes to a fixed-capacity buffer.
+ * Characters past the capacity are dropped, but counted, so the needed size is known after the expansion.
+ */
+class BufferSink
+{
+public:
+    /// Parametrized constructor.
+    BufferSink(char* buffer, std::size_t capacity)
+        : buffer_(buffer)
+        , capacity_(capacity)
+    {
+    }
+
+    /// Writes @p size characters starting from @p data, as many as fit.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        if (size_ < capacity_) {
+            std::memcpy(buffer_ + size_, data, std::min(size, capacity_ - size_));
+        }
+        size_ += size;
+    }
+
+    /// Writes a single character if it fits.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        if (size_ < capacity_) {
+            buffer_[size_] = c;
+        }
+        ++size_;
+    }
+
+    /// Get the number of characters written or dropped.
+    std::size_t Size() const
+    {
+        return size_;
+    }
+
+    /// Check if all characters are written.
+    bool Fits() const
+    {
+        return size_ <= capacity_;
+    }
+
+private:
+    char* buffer_; ///< Buffer to write to.
+    std::size_t capacity_; ///< Size of the buffer.
+    std::size_t size_ = 0; ///< Number of characters written or dropped.
+};
+
+/**
+ * Sink which writes expansion into ScatteredExpansion.
+ * Literals are referred to, everything else is appended to the scratch buffer. Segments of the scratch buffer
+ *  get their pointers in Finish(), when the buffer doesn't grow anymore.
+ */
+class ScatterSink
+{
+public:
+    /// Parametrized constructor, clears @p result.
+    explicit ScatterSink(ScatteredExpansion& result)
+        : result_(result)
+    {
+        result_.segments_.clear();
+        result_.scratch_offsets_.clear();
+        result_.scratch_.clear();
+        result_.size_ = 0;
+    }
+
+    /// Adds a segment referring to the literal.
+    void AppendLiteral(const char* data, std::size_t size)
+    {
+        if (size == 0) {
+            return;
+        }
+        result_.segments_.push_back({data, size});
+        result_.scratch_offsets_.push_back(kLiteral);
+        result_.size_ += size;
+    }
+
+    /// Copies @p size characters starting from @p data to the scratch buffer.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        if (size == 0) {
+            return;
+        }
+        Extend(size);
+        result_.scratch_.append(data, size);
+    }
+
+    /// Copies a single character to the scratch buffer.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        Extend(1);
+        result_.scratch_.push_back(c);
+    }
+
+    /// Points segments of the scratch buffer into it.
+    void Finish()
+    {
+        result_.RebaseScratch();
+    }
+
+private:
+    static constexpr std::size_t kLiteral = ScatteredExpansion::kLiteralOffset;
+
+    /// Grows the last segment of the scratch buffer or starts a new one.
+    void Extend(std::size_t size)
+    {
+        if (result_.segments_.empty() || result_.scratch_offsets_.back() == kLiteral) {
+            result_.segments_.push_back({nullptr, 0});
+            result_.scratch_offsets_.push_back(result_.scratch_.size());
+        }
+        result_.segments_.back().size += size;
+        result_.size_ += size;
+    }
+
+    ScatteredExpansion& result_; ///< Expansion to write to.
+};
+
+/**
+ * Appends literal of a template to @p sink.
+ * Sinks with `AppendLiteral(const char*, std::size_t)` method may refer to the literal instead of copying it.
+ */
+template <class Sink>
+auto AppendLiteral(Sink& sink, const std::string& literal, int) -> decltype(sink.AppendLiteral(nullptr, 0))
+{
+    sink.AppendLiteral(literal.data(), literal.size());
+}
+
+/// Overload for sinks which copy literals.
+template <class Sink>
+void AppendLiteral(Sink& sink, const std::string& literal, long)
+{
+    sink.append(literal.data(), literal.size());
+}
+
+/**
+ * Sink which appends to std::string until the size limit is exceeded.
+ * Output which doesn't fit is dropped and the sink reports it's stopped.
+ */
+class LimitedSink
+{
+public:
+    /// Parametrized constructor, allows to append at most @p max_size characters to @p result.
+    LimitedSink(std::string& result, std::size_t max_size)
+        : result_(result)
+        , remaining_(max_size)
+    {
+    }
+
+    /// Appends @p size characters starting from @p data if they fit.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        if (!Reserve(size)) {
+            return;
+        }
+        result_.append(data, size);
+    }
+
+    /// Appends a single character if it fits.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        if (!Reserve(1)) {
+            return;
+        }
+        result_.push_back(c);
+    }
+
+    /**
+     * Takes @p size characters from the limit.
+     *
+     * @returns false if they don't fit, the sink is stopped then.
+     */
+    bool Reserve(std::size_t size)
+    {
+        if (exceeded_ || size > remaining_) {
+            exceeded_ = true;
+            return false;
+        }
+        remaining_ -= size;
+        return true;
+    }
+
+    /// Get the number of characters which may be appended.
+    std::size_t Remaining() const
+    {
+        return remaining_;
+    }
+
+    /// Get the result the sink appends to.
+    std::string& Result()
+    {
+        return result_;
+    }
+
+    /// Check if the limit is exceeded.
+    bool Stopped() const
+    {
+        return exceeded_;
+    }
+
+private:
+    std::string& result_; ///< Result to append to.
+    std::size_t remaining_; ///< Number of characters which may be appended.
+    bool exceeded_ = false; ///< If some output didn't fit.
+};
+
+/**
+ * Percent-encodes @p value into the limited std::string.
+ * Every character of @p value makes at least one character of the output, so a value longer than the rest
+ *  of the limit is rejected without encoding. A value which fits even if fully encoded is encoded in one go.
+ */
+inline void EncodeTo(LimitedSink& sink, std::string_view value, bool allow_reserved,
+                     std::size_t max_len = std::numeric_limits<std::size_t>::max())
+{
+    if (sink.Stopped()) {
+        return;
+    }
+    const std::size_t min_size = std::min(value.size(), max_len);
+    if (min_size > sink.Remaining()) {
+        sink.Reserve(min_size);
+        return;
+    }
+    if (min_size <= sink.Remaining() / 3) {
+        std::string& result = sink.Result();
+        const std::size_t size = result.size();
+        PctEncode(value, result, allow_reserved, max_len);
+        sink.Reserve(result.size() - size);
+        return;
+    }
+    EncodeTo<LimitedSink>(sink, value, allow_reserved, max_len);
+}
+
+/**
+ * Expression operator properties used by expansion.
+ * Resolved once to avoid virtual calls for each variable.
+ */
+struct OperatorSpec
+{
+    char first; ///< The first character, may be Operator::kNoCharacter.
+    char separator; ///< The separator character.
+    bool named; ///< If variables are named.
+    bool empty_eq; ///< If '=' is used for empty values.
+    bool reserved; ///< If reserved characters are allowed.
+};
+
+/// Resolves properties of the @p oper.
+inline OperatorSpec MakeOperatorSpec(const Operator& oper)
+{
+    return {oper.First(), oper.Separator(), oper.Named(), oper.EmptyEq(), oper.Reserved()};
+}
+
+/**
+ * Variable properties used by expansion.
+ */
+struct VariableSpec
+{
+    std::string_view name; ///< Variable name.
+    bool prefixed; ///< If the variable has ModifierType::LENGTH modifier.
+    bool exploded; ///< If the variable has ModifierType::EXPLODE modifier.
+    unsigned length; ///< Prefix length for the prefixed variable.
+};
+
+/// Resolves properties of the @p var.
+inline VariableSpec MakeVariableSpec(const Variable& var)
+{
+    return {var.Name(), var.IsPrefixed(), var.IsExploded(), var.Length()};
+}
+
+/// Get string representation of @p var_value.
+inline const std::string& StringOf(const VarValue& var_value)
+{
+    return var_value.Get<std::string>();
+}
+
+/// Get string representation of @p var_value.
+inline std::string_view StringOf(const VarValueView& var_value)
+{
+    return var_value.Get<std::string_view>();
+}
+
+/// Get list representation of @p var_value.
+inline const std::vector<std::string>& ListOf(const VarValue& var_value)
+{
+    return var_value.Get<std::vector<std::string>>();
+}
+
+/// Get list representation of @p var_value.
+inline VarValueView::List ListOf(const VarValueView& var_value)
+{
+    return var_value.Get<VarValueView::List>();
+}
+
+/// Get dictionary representation of @p var_value.
+inline const VarDict& DictOf(const VarValue& var_value)
+{
+    return var_value.Get<VarDict>();
+}
+
+/// Get dictionary representation of @p var_value.
+inline VarValueView::Dict DictOf(const VarValueView& var_value)
+{
+    return var_value.Get<VarValueView::Dict>();
+}
+
+/// Size of the buffer which fits any number formatted with FormatNumber().
+constexpr std::size_t kMaxNumberSize = 32;
+
+/**
+ * Formats @p number into @p buffer of @p size characters, at least kMaxNumberSize.
+ * Floating-point numbers are formatted in the shortest representation.
+ *
+ * @returns Formatted number.
+ */
+template <class T>
+std::string_view FormatNumber(T number, char* buffer, std::size_t size)
+{
+    const auto formatted = std::to_chars(buffer, buffer + size, number);
+    return {buffer, static_cast<std::size_t>(formatted.ptr - buffer)};
+}
+
+/**
+ * Writes expansion of the variables of a single expression into a sink.
+ * Writer keeps track of the first item to put operator's first character or separator.
+ */
+template <class Sink>
+class ExpressionWriter
+{
+public:
+    /**
+     * Parametrized constructor.
+     *
+     * @param[in] oper Properties of the expression operator.
+     * @param[out] sink A sink to write to.
+     */
+    ExpressionWriter(const OperatorSpec& oper, Sink& sink)
+        : oper_(oper)
+        , sink_(sink)
+    {
+    }
+
+    /**
+     * Writes expansion of a variable.
+     *
+     * @param[in] var Properties of the variable.
+     * @param[in] var_value The variable value, either VarValue or VarValueView.
+     */
+    template <class Value>
+    void Write(const VariableSpec& var, const Value& var_value)
+    {
+        switch (var_value.Type()) {
+        case VarType::UNDEFINED:
+            break;
+
+        case VarType::STRING: {
+            const auto& value = StringOf(var_value);
+            const bool pre_encoded = var_value.IsPreEncoded();
+            StartItem();
+            if (oper_.named) {
+                PutName(var.name, value.empty());
+            }
+            if (var.prefixed) {
+                PutValue(value, pre_encoded, var.length);
+            } else {
+                PutValue(value, pre_encoded);
+            }
+        } break;
+
+        case VarType::LIST: {
+            const auto& list = ListOf(var_value);
+            const bool pre_encoded = var_value.IsPreEncoded();
+            if (var.exploded) {
+                for (const auto& list_item : list) {
+                    if (IsStopped(sink_)) {
+                        return;
+                    }
+                    StartItem();
+                    if (oper_.named) {
+                        PutName(var.name, list_item.empty());
+                    }
+                    PutValue(list_item, pre_encoded);
+                }
+            } else {
+                StartItem();
+                if (oper_.named) {
+                    // joined value is empty only if there is nothing to join
+                    PutName(var.name, list.empty() || (list.size() == 1 && list.front().empty()));
+                }
+                bool first_item = true;
+                for (const auto& list_item : list) {
+                    if (IsStopped(sink_)) {
+                        return;
+                    }
+                    if (!first_item) {
+                        sink_.push_back(',');
+                    }
+                    PutValue(list_item, pre_encoded);
+                    first_item = false;
+                }
+            }
+        } break;
+
+        case VarType::DICT: {
+            const auto& dict = DictOf(var_value);
+            const bool pre_encoded = var_value.IsPreEncoded();
+            if (var.exploded) {
+                for (const auto& [name, val] : dict) {
+                    if (IsStopped(sink_)) {
+                        return;
+                    }
+                    StartItem();
+                    PutValue(name, pre_encoded);
+                    if (!val.empty() || oper_.empty_eq) {
+                        sink_.push_back('=');
+                    }
+                    PutValue(val, pre_encoded);
+                }
+            } else {
+                StartItem();
+                if (oper_.named) {
+                    PutName(var.name, dict.empty());
+                }
+                bool first_item = true;
+                for (const auto& [name, val] : dict) {
+                    if (IsStopped(sink_)) {
+                        return;
+                    }
+                    if (!first_item) {
+                        sink_.push_back(',');
+                    }
+                    PutValue(name, pre_encoded);
+                    sink_.push_back(',');
+                    PutValue(val, pre_encoded);
+                    first_item = false;
+                }
+            }
+        } break;
+
+        case VarType::INT64:
+            WriteNumber(var, var_value.template Get<std::int64_t>());
+            break;
+
+        case VarType::UINT64:
+            WriteNumber(var, var_value.template Get<std::uint64_t>());
+            break;
+
+        case VarType::DOUBLE:
+            WriteNumber(var, var_value.template Get<double>());
+            break;
+
+        case VarType::BOOL:
+            WriteScalar(var, var_value.template Get<bool>() ? "true" : "false", true);
+            break;
+        }
+    }
+
+private:
+    /// Formats @p number straight into the sink.
+    template <class T>
+    void WriteNumber(const VariableSpec& var, T number)
+    {
+        char buffer[kMaxNumberSize];
+        // integers are made of digits and '-' only, exponent of a floating-point number may have '+'
+        WriteScalar(var, FormatNumber(number, buffer, sizeof(buffer)), std::is_integral<T>::value);
+    }
+
+    /**
+     * Writes formatted number or boolean.
+     * If @p is_safe then @p value has only unreserved characters and is copied without encoding.
+     */
+    void WriteScalar(const VariableSpec& var, std::string_view value, bool is_safe)
+    {
+        StartItem();
+        if (oper_.named) {
+            PutName(var.name, value.empty());
+        }
+        if (!is_safe) {
+            EncodeTo(sink_, value, oper_.reserved, var.prefixed ? var.length : std::numeric_limits<std::size_t>::max());
+            return;
+        }
+        if (var.prefixed && var.length < value.size()) {
+            value = value.substr(0, var.length);
+        }
+        sink_.append(value.data(), value.size());
+    }
+
+    /**
+     * Puts @p value percent-encoded, or as is if it's @p pre_encoded.
+     * Prefixed pre-encoded value is percent-encoded anyway to count triplets as single characters.
+     */
+    void PutValue(std::string_view value, bool pre_encoded,
+                  std::size_t max_len = std::numeric_limits<std::size_t>::max())
+    {
+        if (pre_encoded && max_len >= value.size()) {
+            assert(IsPctEncoded(value, oper_.reserved) && "pre-encoded value has characters to encode");
+            sink_.append(value.data(), value.size());
+            return;
+        }
+        EncodeTo(sink_, value, oper_.reserved, max_len);
+    }
+
+    /// Puts operator's first character before the first item and separator before others.
+    void StartItem()
+    {
+        if (first_) {
+            first_ = false;
+            if (oper_.first != Operator::kNoCharacter) {
+                sink_.push_back(oper_.first);
+            }
+        } else {
+            sink_.push_back(oper_.separator);
+        }
+    }
+
+    /// Puts name of named variable and '=' if needed.
+    void PutName(std::string_view name, bool empty_value)
+    {
+        sink_.append(name.data(), name.size());
+        if (!empty_value || oper_.empty_eq) {
+            sink_.push_back('=');
+        }
+    }
+
+    const OperatorSpec& oper_; ///< Operator properties.
+    Sink& sink_; ///< Sink to write to.
+    bool first_ = true; ///< If nothing has been written yet.
+};
+
+/**
+ * Expands a single template expression into @p sink.
+ * The same as ExpandExpression(), but variables values are located with @p lookup:
+ *  `const VarValue* lookup(const Variable&)` or `const VarValueView* lookup(const Variable&)`,
+ *  where nullptr means undefined variable.
+ */
+template <class Sink, class Lookup>
+void ExpandExpressionTo(const Expression& expression, Lookup&& lookup, Sink& sink)
+{
+    const std::vector<Variable>& variables = expression.Vars();
+    if (variables.empty()) {
+        throw std::runtime_error("expression is empty");
+    }
+
+    const OperatorSpec oper = MakeOperatorSpec(expression.Oper());
+    ExpressionWriter<Sink> writer(oper, sink);
+    for (const Variable& var : variables) {
+        if (IsStopped(sink)) {
+            return;
+        }
+        const auto* var_value = lookup(var);
+        if (var_value != nullptr) {
+            writer.Write(MakeVariableSpec(var), *var_value);
+        }
+    }
+}
+
+/**
+ * Expands uri-template into @p sink.
+ * The same as ExpandTemplate(), but variables values are located with @p lookup. See ExpandExpressionTo().
+ * Expansion stops between parts, variables and items once IsStopped() is true for the @p sink.
+ */
+template <class Sink, class Lookup>
+void ExpandTemplateTo(const Template& uri_template, Lookup&& lookup, Sink& sink)
+{
+    for (const auto& part : uri_template.Parts()) {
+        if (IsStopped(sink)) {
+            return;
+        }
+        switch (part.Type()) {
+        case PartType::LITERAL:
+            AppendLiteral(sink, part.Get<Literal>().String(), 0);
+            break;
+        case PartType::EXPRESSION:
+            ExpandExpressionTo(part.Get<Expression>(), lookup, sink);
+            break;
+        }
+    }
+}
+
+/// Get name of the variable of a template.
+inline const std::string& NameOf(const Variable& var)
+{
+    return var.Name();
+}
+
+/// Get name of the variable of a compiled template, see CompiledExpander::VariableInfo.
+template <class Var>
+auto NameOf(const Var& var) -> decltype((var.name))
+{
+    return var.name;
+}
+
+/**
+ * Creates lookup over the map of values or values views.
+ * Serves both ExpandExpressionTo() and CompiledExpander::ExpandTo().
+ */
+template <class Map>
+auto MapLookup(const Map& values)
+{
+    return [&values](const auto& var) -> const typename Map::mapped_type* {
+        const auto value_lookup = values.find(NameOf(var));
+        if (value_lookup == values.end()) {
+            return nullptr;
+        }
+        return &value_lookup->second;
+    };
+}
+
+/// Creates lookup for ExpandExpressionTo() over the @p resolver.
+inline auto ResolverLookup(ValueResolver resolver)
+{
+    return [resolver, value = std::optional<VarValueView>()](const Variable& var) mutable -> const VarValueView* {
+        value = resolver(var.Name());
+        return value ? &*value : nullptr;
+    };
+}
+
+/// Creates lookup for ExpandExpressionTo() over the stack of scopes.
+inline auto ScopeLookup(const ValueScope& scope)
+{
+    return [&scope](const Variable& var) { return scope.Find(var.Name()); };
+}
+
+} // namespace detail
+} // namespace Template
+} // namespace URI
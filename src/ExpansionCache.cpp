@@ -0,0 +1,266 @@
+#include "uri-template/ExpansionCache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <stdexcept>
+
+namespace {
+
+/// Appends raw bytes of @p number to @p key.
+template <class T>
+void AppendRaw(std::string& key, T number)
+{
+    char buffer[sizeof(T)];
+    std::memcpy(buffer, &number, sizeof(T));
+    key.append(buffer, sizeof(T));
+}
+
+/// Appends length-prefixed @p str to @p key, so concatenation of strings is unambiguous.
+void AppendString(std::string& key, std::string_view str)
+{
+    AppendRaw(key, str.size());
+    key.append(str.data(), str.size());
+}
+
+/// Appends type, pre-encoded flag and contents of @p var_value to @p key, nullptr means undefined variable.
+void AppendValue(std::string& key, const URI::Template::VarValue* var_value)
+{
+    using URI::Template::VarType;
+
+    if (var_value == nullptr) {
+        key.push_back(static_cast<char>(VarType::UNDEFINED));
+        return;
+    }
+
+    key.push_back(static_cast<char>(var_value->Type()));
+    key.push_back(var_value->IsPreEncoded() ? '\1' : '\0');
+    switch (var_value->Type()) {
+    case VarType::UNDEFINED:
+        break;
+
+    case VarType::STRING:
+        AppendString(key, var_value->Get<std::string>());
+        break;
+
+    case VarType::LIST: {
+        const auto& list = var_value->Get<std::vector<std::string>>();
+        AppendRaw(key, list.size());
+        for (const auto& list_item : list) {
+            AppendString(key, list_item);
+        }
+    } break;
+
+    case VarType::DICT: {
+        // items order matters for expansion, so dicts with the same items in different order are different keys
+        const auto& dict = var_value->Get<URI::Template::VarDict>();
+        AppendRaw(key, dict.size());
+        for (const auto& [name, val] : dict) {
+            AppendString(key, name);
+            AppendString(key, val);
+        }
+    } break;
+
+    case VarType::INT64:
+        AppendRaw(key, var_value->Get<std::int64_t>());
+        break;
+
+    case VarType::UINT64:
+        AppendRaw(key, var_value->Get<std::uint64_t>());
+        break;
+
+    case VarType::DOUBLE:
+        AppendRaw(key, var_value->Get<double>());
+        break;
+
+    case VarType::BOOL:
+        AppendRaw(key, var_value->Get<bool>());
+        break;
+    }
+}
+
+/**
+ * Serializes values of the variables of @p uri_template into @p key.
+ * Two expansions of the same template are equal if their keys are equal.
+ */
+void MakeKey(const URI::Template::Template& uri_template,
+             const std::unordered_map<std::string, URI::Template::VarValue>& values, std::string& key)
+{
+    for (const auto& part : uri_template.Parts()) {
+        if (part.Type() != URI::Template::PartType::EXPRESSION) {
+            continue;
+        }
+        for (const auto& var : part.Get<URI::Template::Expression>().Vars()) {
+            const auto value_lookup = values.find(var.Name());
+            AppendString(key, var.Name());
+            AppendValue(key, value_lookup == values.end() ? nullptr : &value_lookup->second);
+        }
+    }
+}
+
+/// Combines hash of @p key with the template address.
+std::size_t HashKey(const URI::Template::Template* uri_template, std::string_view key)
+{
+    std::size_t hash = std::hash<std::string_view>()(key);
+    hash ^= std::hash<const void*>()(uri_template) + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+    return hash;
+}
+
+/// Size of a cache line on common CPUs.
+constexpr std::size_t kCacheLineSize = 64;
+
+} // namespace
+
+/**
+ * Part of the cache with its own lock.
+ * Entries are kept in the LRU list, the most recently used first, and indexed by the key hash.
+ * Shards are aligned to cache lines, so locking and counters of one shard don't slow down the neighbours.
+ */
+struct alignas(kCacheLineSize) URI::Template::ExpansionCache::Shard
+{
+    /// Cached expansion result.
+    struct Entry
+    {
+        const Template* uri_template; ///< Expanded template.
+        std::size_t hash; ///< Hash of the key.
+        std::string key; ///< Serialized values of the template variables, see MakeKey().
+        std::shared_ptr<const std::string> result; ///< Expansion result.
+    };
+
+    using EntryIter = std::list<Entry>::iterator;
+
+    /// Finds the entry and marks it as the most recently used. Should be called with the mutex locked.
+    EntryIter Find(const Template* uri_template, std::size_t hash, std::string_view key)
+    {
+        const auto range = index.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            const EntryIter entry = it->second;
+            if (entry->uri_template == uri_template && entry->key == key) {
+                entries.splice(entries.begin(), entries, entry);
+                return entry;
+            }
+        }
+        return entries.end();
+    }
+
+    /// Drops the least recently used entry. Should be called with the mutex locked.
+    void EvictLast()
+    {
+        const EntryIter entry = std::prev(entries.end());
+        const auto range = index.equal_range(entry->hash);
+        index.erase(std::find_if(range.first, range.second, [&entry](const auto& item) { return item.second == entry; }));
+        entries.erase(entry);
+    }
+
+    std::size_t capacity = 0; ///< Maximum number of entries.
+    mutable std::mutex mutex; ///< Guards entries and index.
+    std::list<Entry> entries; ///< Entries, the most recently used first.
+    std::unordered_multimap<std::size_t, EntryIter> index; ///< Entries by the key hash.
+    std::atomic<std::uint64_t> hits{0}; ///< Number of hits.
+    std::atomic<std::uint64_t> misses{0}; ///< Number of misses.
+    std::atomic<std::uint64_t> evictions{0}; ///< Number of evictions.
+};
+
+URI::Template::ExpansionCache::ExpansionCache(std::size_t capacity, std::size_t shards)
+{
+    if (shards == 0) {
+        throw std::invalid_argument("cache should have at least one shard");
+    }
+    // every shard keeps at least one entry, and the remainder is spread, so the total is exactly the capacity
+    shards = std::max<std::size_t>(1, std::min(shards, capacity));
+    shards_.reserve(shards);
+    for (std::size_t i = 0; i < shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>());
+        shards_.back()->capacity = capacity / shards + (i < capacity % shards ? 1 : 0);
+    }
+}
+
+URI::Template::ExpansionCache::~ExpansionCache() = default;
+
+std::shared_ptr<const std::string> URI::Template::ExpansionCache::Expand(
+    const Template& uri_template, const std::unordered_map<std::string, VarValue>& values)
+{
+    // key buffer is reused between calls, so a hit doesn't allocate
+    thread_local std::string key;
+    key.clear();
+    MakeKey(uri_template, values, key);
+    const std::size_t hash = HashKey(&uri_template, key);
+    Shard& shard = *shards_[hash % shards_.size()];
+
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        const auto entry = shard.Find(&uri_template, hash, key);
+        if (entry != shard.entries.end()) {
+            shard.hits.fetch_add(1, std::memory_order_relaxed);
+            return entry->result;
+        }
+    }
+
+    shard.misses.fetch_add(1, std::memory_order_relaxed);
+    auto result = std::make_shared<const std::string>(ExpandTemplate(uri_template, values));
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    // another thread could have stored the same result while this one was expanding
+    const auto entry = shard.Find(&uri_template, hash, key);
+    if (entry != shard.entries.end()) {
+        return entry->result;
+    }
+    if (shard.capacity == 0) {
+        return result;
+    }
+    if (shard.entries.size() >= shard.capacity) {
+        shard.EvictLast();
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+    shard.entries.push_front({&uri_template, hash, key, result});
+    shard.index.emplace(hash, shard.entries.begin());
+    return result;
+}
+
+void URI::Template::ExpansionCache::Clear()
+{
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->index.clear();
+        shard->entries.clear();
+    }
+}
+
+std::size_t URI::Template::ExpansionCache::Size() const
+{
+    std::size_t size = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        size += shard->entries.size();
+    }
+    return size;
+}
+
+std::uint64_t URI::Template::ExpansionCache::Hits() const
+{
+    std::uint64_t hits = 0;
+    for (const auto& shard : shards_) {
+        hits += shard->hits.load(std::memory_order_relaxed);
+    }
+    return hits;
+}
+
+std::uint64_t URI::Template::ExpansionCache::Misses() const
+{
+    std::uint64_t misses = 0;
+    for (const auto& shard : shards_) {
+        misses += shard->misses.load(std::memory_order_relaxed);
+    }
+    return misses;
+}
+
+std::uint64_t URI::Template::ExpansionCache::Evictions() const
+{
+    std::uint64_t evictions = 0;
+    for (const auto& shard : shards_) {
+        evictions += shard->evictions.load(std::memory_order_relaxed);
+    }
+    return evictions;
+}
@@ -0,0 +1,141 @@
+#include "uri-template/ExpansionProduct.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+URI::Template::ExpansionProduct::ExpansionProduct(const Template& uri_template, std::vector<Axis> axes,
+                                                  std::unordered_map<std::string, VarValue> values)
+    : uri_template_(uri_template)
+    , axes_(std::move(axes))
+    , values_(std::move(values))
+    , size_(1)
+{
+    for (const auto& [name, candidates] : axes_) {
+        if (!candidates.empty() && size_ > std::numeric_limits<std::size_t>::max() / candidates.size()) {
+            throw std::overflow_error("too many combinations");
+        }
+        size_ *= candidates.size();
+    }
+}
+
+std::size_t URI::Template::ExpansionProduct::Size() const
+{
+    return size_;
+}
+
+URI::Template::ExpansionProduct::Iterator URI::Template::ExpansionProduct::begin() const
+{
+    return Slice(0, size_).begin();
+}
+
+URI::Template::ExpansionProduct::Iterator URI::Template::ExpansionProduct::end() const
+{
+    return Slice(0, size_).end();
+}
+
+URI::Template::ExpansionProduct::Range URI::Template::ExpansionProduct::Slice(std::size_t first,
+                                                                              std::size_t last) const
+{
+    last = std::min(last, size_);
+    return Range(*this, std::min(first, last), last);
+}
+
+URI::Template::ExpansionProduct::Range::Range(const ExpansionProduct& product, std::size_t first, std::size_t last)
+    : product_(&product)
+    , first_(first)
+    , last_(last)
+{
+}
+
+URI::Template::ExpansionProduct::Iterator URI::Template::ExpansionProduct::Range::begin() const
+{
+    return Iterator(*product_, first_, last_);
+}
+
+URI::Template::ExpansionProduct::Iterator URI::Template::ExpansionProduct::Range::end() const
+{
+    return Iterator(*product_, last_, last_);
+}
+
+std::size_t URI::Template::ExpansionProduct::Range::Size() const
+{
+    return last_ - first_;
+}
+
+URI::Template::ExpansionProduct::Iterator::Iterator(const ExpansionProduct& product, std::size_t index,
+                                                    std::size_t end)
+    : product_(&product)
+    , index_(index)
+    , end_(end)
+{
+    if (index_ == end_) {
+        return;
+    }
+
+    // the last axis changes the fastest, so positions are digits of the index in mixed radix
+    positions_.resize(product.axes_.size());
+    auto values = product.values_;
+    std::size_t rest = index_;
+    for (std::size_t axis = product.axes_.size(); axis-- > 0;) {
+        const auto& [name, candidates] = product.axes_[axis];
+        positions_[axis] = rest % candidates.size();
+        rest /= candidates.size();
+        values.insert_or_assign(name, candidates[positions_[axis]]);
+    }
+    state_.emplace(product.uri_template_, std::move(values));
+}
+
+const std::string& URI::Template::ExpansionProduct::Iterator::operator*() const
+{
+    return state_->String();
+}
+
+const std::string* URI::Template::ExpansionProduct::Iterator::operator->() const
+{
+    return &state_->String();
+}
+
+URI::Template::ExpansionProduct::Iterator& URI::Template::ExpansionProduct::Iterator::operator++()
+{
+    if (++index_ == end_) {
+        state_.reset();
+        return *this;
+    }
+
+    // odometer step: the last axis moves forward, wrapped axes carry to the previous one
+    for (std::size_t axis = positions_.size(); axis-- > 0;) {
+        const auto& [name, candidates] = product_->axes_[axis];
+        const bool carry = ++positions_[axis] == candidates.size();
+        if (carry) {
+            positions_[axis] = 0;
+        }
+        state_->Update(name, candidates[positions_[axis]]);
+        if (!carry) {
+            break;
+        }
+    }
+    return *this;
+}
+
+bool URI::Template::ExpansionProduct::Iterator::operator==(const Iterator& rhs) const
+{
+    return index_ == rhs.index_;
+}
+
+bool URI::Template::ExpansionProduct::Iterator::operator!=(const Iterator& rhs) const
+{
+    return !(*this == rhs);
+}
+
+std::size_t URI::Template::ExpansionProduct::Iterator::Index() const
+{
+    return index_;
+}
+
+const URI::Template::VarValue* URI::Template::ExpansionProduct::Iterator::Value(const std::string& name) const
+{
+    const auto& values = state_->Values();
+    const auto value_lookup = values.find(name);
+    return value_lookup == values.end() ? nullptr : &value_lookup->second;
+}
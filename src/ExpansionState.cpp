@@ -0,0 +1,70 @@
+#include "uri-template/ExpansionState.h"
+
+#include "Expansion.h"
+
+URI::Template::ExpansionState::ExpansionState(const Template& uri_template,
+                                              std::unordered_map<std::string, VarValue> values)
+    : values_(std::move(values))
+{
+    for (const auto& part : uri_template.Parts()) {
+        switch (part.Type()) {
+        case PartType::LITERAL:
+            result_ += part.Get<Literal>().String();
+            break;
+
+        case PartType::EXPRESSION: {
+            const auto& expression = part.Get<Expression>();
+            const std::size_t begin = result_.size();
+            detail::ExpandExpressionTo(expression, detail::MapLookup(values_), result_);
+            for (const auto& var : expression.Vars()) {
+                auto& dependent = dependents_[var.Name()];
+                // the same variable may be used twice in the expression
+                if (dependent.empty() || dependent.back() != segments_.size()) {
+                    dependent.push_back(segments_.size());
+                }
+            }
+            segments_.push_back({&expression, begin, result_.size() - begin});
+        } break;
+        }
+    }
+}
+
+void URI::Template::ExpansionState::Update(const std::string& name, VarValue value)
+{
+    values_.insert_or_assign(name, std::move(value));
+
+    const auto dependent = dependents_.find(name);
+    if (dependent == dependents_.end()) {
+        return;
+    }
+
+    // segments are in order of the result, so a size change shifts the following ones only
+    std::ptrdiff_t shift = 0;
+    std::size_t next = 0;
+    for (const std::size_t index : dependent->second) {
+        for (; next < index; ++next) {
+            segments_[next].begin += shift;
+        }
+        auto& segment = segments_[index];
+        segment.begin += shift;
+        scratch_.clear();
+        detail::ExpandExpressionTo(*segment.expression, detail::MapLookup(values_), scratch_);
+        result_.replace(segment.begin, segment.size, scratch_);
+        shift += static_cast<std::ptrdiff_t>(scratch_.size()) - static_cast<std::ptrdiff_t>(segment.size);
+        segment.size = scratch_.size();
+        next = index + 1;
+    }
+    for (; next < segments_.size(); ++next) {
+        segments_[next].begin += shift;
+    }
+}
+
+const std::string& URI::Template::ExpansionState::String() const
+{
+    return result_;
+}
+
+const std::unordered_map<std::string, URI::Template::VarValue>& URI::Template::ExpansionState::Values() const
+{
+    return values_;
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace URI {
+namespace Template {
+namespace detail { // NOLINT(readability-identifier-naming)
+
+/**
+ * Sink which doesn't store anything, but hashes characters appended to it with XXH64.
+ * Hash doesn't depend on how the input is split into append() calls: it's the same as XXH64 of
+ *  the concatenated input with the same seed.
+ */
+class HashSink
+{
+public:
+    /// Parametrized constructor.
+    explicit HashSink(std::uint64_t seed)
+        : seed_(seed)
+        , acc_{seed + kPrime1 + kPrime2, seed + kPrime2, seed, seed - kPrime1}
+    {
+    }
+
+    /// Hashes @p size characters starting from @p data.
+    void append(const char* data, std::size_t size) // NOLINT(readability-identifier-naming)
+    {
+        const auto* input = reinterpret_cast<const unsigned char*>(data);
+        total_ += size;
+
+        if (buffered_ != 0) {
+            const std::size_t fill = std::min(size, kStripeSize - buffered_);
+            std::memcpy(buffer_ + buffered_, input, fill);
+            buffered_ += fill;
+            input += fill;
+            size -= fill;
+            if (buffered_ < kStripeSize) {
+                return;
+            }
+            Stripe(buffer_);
+            buffered_ = 0;
+        }
+
+        for (; size >= kStripeSize; input += kStripeSize, size -= kStripeSize) {
+            Stripe(input);
+        }
+
+        if (size != 0) {
+            std::memcpy(buffer_, input, size);
+            buffered_ = size;
+        }
+    }
+
+    /// Hashes a single character.
+    void push_back(char c) // NOLINT(readability-identifier-naming)
+    {
+        buffer_[buffered_++] = static_cast<unsigned char>(c);
+        ++total_;
+        if (buffered_ == kStripeSize) {
+            Stripe(buffer_);
+            buffered_ = 0;
+        }
+    }
+
+    /// Get hash of the characters appended so far.
+    std::uint64_t Digest() const
+    {
+        std::uint64_t hash;
+        if (total_ >= kStripeSize) {
+            hash = Rotl(acc_[0], 1) + Rotl(acc_[1], 7) + Rotl(acc_[2], 12) + Rotl(acc_[3], 18);
+            for (const std::uint64_t acc : acc_) {
+                hash ^= Round(0, acc);
+                hash = hash * kPrime1 + kPrime4;
+            }
+        } else {
+            hash = seed_ + kPrime5;
+        }
+        hash += total_;
+
+        const unsigned char* tail = buffer_;
+        std::size_t size = buffered_;
+        for (; size >= 8; tail += 8, size -= 8) {
+            hash ^= Round(0, Read64(tail));
+            hash = Rotl(hash, 27) * kPrime1 + kPrime4;
+        }
+        if (size >= 4) {
+            hash ^= Read32(tail) * kPrime1;
+            hash = Rotl(hash, 23) * kPrime2 + kPrime3;
+            tail += 4;
+            size -= 4;
+        }
+        for (; size != 0; ++tail, --size) {
+            hash ^= *tail * kPrime5;
+            hash = Rotl(hash, 11) * kPrime1;
+        }
+
+        hash ^= hash >> 33;
+        hash *= kPrime2;
+        hash ^= hash >> 29;
+        hash *= kPrime3;
+        hash ^= hash >> 32;
+        return hash;
+    }
+
+private:
+    static constexpr std::uint64_t kPrime1 = 11400714785074694791ULL;
+    static constexpr std::uint64_t kPrime2 = 14029467366897019727ULL;
+    static constexpr std::uint64_t kPrime3 = 1609587929392839161ULL;
+    static constexpr std::uint64_t kPrime4 = 9650029242287828579ULL;
+    static constexpr std::uint64_t kPrime5 = 2870177450012600261ULL;
+    static constexpr std::size_t kStripeSize = 32;
+
+    static std::uint64_t Rotl(std::uint64_t value, int shift)
+    {
+        return (value << shift) | (value >> (64 - shift));
+    }
+
+    /// Reads little-endian 64-bit number regardless of the platform byte order.
+    static std::uint64_t Read64(const unsigned char* input)
+    {
+        std::uint64_t value = 0;
+        for (int i = 7; i >= 0; --i) {
+            value = (value << 8) | input[i];
+        }
+        return value;
+    }
+
+    /// Reads little-endian 32-bit number regardless of the platform byte order.
+    static std::uint64_t Read32(const unsigned char* input)
+    {
+        std::uint64_t value = 0;
+        for (int i = 3; i >= 0; --i) {
+            value = (value << 8) | input[i];
+        }
+        return value;
+    }
+
+    static std::uint64_t Round(std::uint64_t acc, std::uint64_t input)
+    {
+        acc += input * kPrime2;
+        return Rotl(acc, 31) * kPrime1;
+    }
+
+    /// Mixes 32 bytes of the input into the accumulators.
+    void Stripe(const unsigned char* input)
+    {
+        for (std::size_t i = 0; i < 4; ++i) {
+            acc_[i] = Round(acc_[i], Read64(input + i * 8));
+        }
+    }
+
+    std::uint64_t seed_; ///< Hash seed.
+    std::uint64_t acc_[4]; ///< Stripe accumulators.
+    unsigned char buffer_[kStripeSize] = {}; ///< Input which doesn't fill a stripe yet.
+    std::size_t buffered_ = 0; ///< Number of characters in buffer_.
+    std::uint64_t total_ = 0; ///< Number of characters appended.
+};
+
+} // namespace detail
+} // namespace Template
+} // namespace URI
@@ -1,5 +1,11 @@
 #include "uri-template/Matcher.h"
 
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <new>
+#include <unordered_set>
+
 namespace {
 
 enum class ExprParts
@@ -14,82 +20,99 @@ enum class VarParts
     VALUE,
 };
 
-bool StartsWith(const std::string& str, const std::string& prefix)
+bool StartsWith(std::string_view str, std::string_view prefix)
 {
     // in c++17 we don't have starts_with()
-    const auto str_start = std::string_view(str).substr(0, prefix.size());
+    const auto str_start = str.substr(0, prefix.size());
     if (str_start == prefix) {
         return true;
     }
     return false;
 }
 
-} // namespace
-
-URI::Template::Match::Match(std::size_t start, std::size_t end)
-    : start_(start)
-    , end_(end)
-{
-}
-
-std::size_t URI::Template::Match::Start() const
-{
-    return start_;
-}
-
-std::size_t URI::Template::Match::End() const
+int HexValue(char c)
 {
-    return end_;
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    return -1;
 }
 
-std::optional<URI::Template::Match> URI::Template::MatchLiteral(const Literal& literal, const std::string& where,
-                                                                std::size_t start, bool exact_start)
+// formatted numbers may only have encoded '+' in exponent, so decode triplets before parsing
+std::string PctDecode(std::string_view str)
 {
-    if (start + literal.Size() > where.size()) {
-        // literal doesn't fit in where
-        return std::nullopt;
-    }
-
-    if (exact_start) {
-        if (!StartsWith(where, literal.String())) {
-            return std::nullopt;
+    std::string result;
+    result.reserve(str.size());
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        if (str[i] == '%' && i + 2 < str.size() && HexValue(str[i + 1]) >= 0 && HexValue(str[i + 2]) >= 0) {
+            result += static_cast<char>(HexValue(str[i + 1]) * 16 + HexValue(str[i + 2]));
+            i += 2;
+        } else {
+            result += str[i];
         }
-        return Match(start, start + literal.Size());
     }
+    return result;
+}
 
-    std::size_t m_start = where.find(literal.String(), start);
-    if (m_start == std::string::npos) {
+template <class T>
+std::optional<URI::Template::VarValue> ParseNumber(std::string_view str)
+{
+    T number{};
+    const auto parsed = std::from_chars(str.data(), str.data() + str.size(), number);
+    if (parsed.ec != std::errc() || parsed.ptr != str.data() + str.size()) {
         return std::nullopt;
     }
-    return Match(m_start, m_start + literal.Size());
+    return URI::Template::VarValue(number);
 }
 
-std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variable& var, const Operator& oper,
-                                                                    std::optional<std::string>&& where)
+// variable value split into views of names and values of the matched string, see MatchVarValue()
+struct ParsedValue
 {
+    URI::Template::VarType type;
+    std::pmr::vector<std::string_view> names;
+    std::pmr::vector<std::string_view> values;
+};
+
+// splits the matched value of the variable, temporary containers are allocated from the resource
+std::optional<ParsedValue> ParseVarValue(const URI::Template::Variable& var, const URI::Template::Operator& oper,
+                                         std::optional<std::string_view> where, std::pmr::memory_resource* resource)
+{
+    using URI::Template::VarType;
+
+    ParsedValue parsed{VarType::STRING, std::pmr::vector<std::string_view>(resource),
+                       std::pmr::vector<std::string_view>(resource)};
     if (!where) {
         // treat undefined exploded as an empty list
-        return var.IsExploded() ? VarValue(VarType::LIST) : VarValue(VarType::UNDEFINED);
+        parsed.type = var.IsExploded() ? VarType::LIST : VarType::UNDEFINED;
+        return parsed;
     }
 
     if (oper.Reserved()) {
         // reserved operator can contain all symbols in a string
-        auto value = VarValue(VarType::STRING);
-        value.Get<std::string>() = std::move(*where);
+        parsed.values.push_back(*where);
         // TODO: exploded reserved
-        return value;
+        return parsed;
     }
 
+    auto& names = parsed.names;
+    auto& values = parsed.values;
+    std::pmr::unordered_set<std::string_view> names_set(resource);
+
+    // parts are contiguous, so they are views of where
     std::size_t pos = 0;
-    std::string parsed_part;
-    std::vector<std::string> names;
-    std::vector<std::string> values;
-    std::unordered_set<std::string> names_set;
+    std::size_t part_start = 0;
+    const auto parsed_part = [&where, &pos, &part_start]() { return where->substr(part_start, pos - part_start); };
 
     VarType var_type = VarType::STRING;
     VarParts parsing = oper.Named() ? VarParts::NAME : VarParts::VALUE;
     while (pos < where->size()) {
-        char cur_char = where->at(pos);
+        char cur_char = (*where)[pos];
 
         switch (parsing) {
         case VarParts::NAME:
@@ -101,11 +124,9 @@ std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variab
                     return std::nullopt;
                 }
 
-                names_set.emplace(names.emplace_back(std::move(parsed_part)));
-                parsed_part.clear();
+                names_set.emplace(names.emplace_back(parsed_part()));
+                part_start = pos + 1;
                 parsing = VarParts::VALUE;
-            } else {
-                parsed_part += cur_char;
             }
             break;
 
@@ -115,22 +136,19 @@ std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variab
                 continue;
             } else if (cur_char == ',') {
                 var_type = VarType::LIST;
-                values.emplace_back(std::move(parsed_part));
-                parsed_part.clear();
+                values.emplace_back(parsed_part());
+                part_start = pos + 1;
             } else if (cur_char == oper.Separator()) {
                 if (cur_char == '.' && pos < where->size() - 1 &&
-                    (where->at(pos + 1) == cur_char || where->at(pos + 1) == ',')) {
+                    ((*where)[pos + 1] == cur_char || (*where)[pos + 1] == ',')) {
                     // if current and next either '.' or ',' then greedy
-                    parsed_part += cur_char;
                 } else {
                     if (var.IsExploded() && var_type == VarType::STRING) {
                         var_type = VarType::LIST;
                     }
-                    values.emplace_back(std::move(parsed_part));
-                    parsed_part.clear();
+                    values.emplace_back(parsed_part());
+                    part_start = pos + 1;
                 }
-            } else {
-                parsed_part += cur_char;
             }
             break;
         }
@@ -139,21 +157,18 @@ std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variab
     }
     switch (parsing) {
     case VarParts::NAME:
-        names.emplace_back(std::move(parsed_part));
+        names.emplace_back(parsed_part());
         if (!oper.EmptyEq()) {
             values.emplace_back("");
         }
         break;
     case VarParts::VALUE:
-        values.emplace_back(std::move(parsed_part));
+        values.emplace_back(parsed_part());
         break;
     }
 
-    VarValue var_value(var_type);
+    parsed.type = var_type;
     switch (var_type) {
-    case VarType::UNDEFINED:
-        break;
-
     case VarType::STRING:
         if (oper.Named()) {
             if (names.size() != 1) {
@@ -168,53 +183,239 @@ std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variab
         if (values.size() != 1) {
             // string should have exactly one value
             return std::nullopt;
-        } else {
-            var_value.Get<std::string>() = std::move(values[0]);
         }
         break;
 
-    case VarType::LIST:
-        var_value.Get<std::vector<std::string>>() = std::move(values);
-        break;
-
-    case VarType::DICT: {
+    case VarType::DICT:
         if (names.size() != values.size()) {
             // dict has unequal number of names and values
             return std::nullopt;
         }
         if (names_set.size() == 1 && names[0] == var.Name()) {
             // vars with same name as this variable
-            var_value = VarValue(VarType::LIST);
-            var_value.Get<std::vector<std::string>>() = std::move(values);
-        } else if (names_set.size() == values.size()) {
-            // vars with unique names
-            auto& dict = var_value.Get<std::unordered_map<std::string, std::string>>();
-            for (std::size_t i = 0; i < names.size(); ++i) {
-                dict.emplace(std::move(names[i]), std::move(values[i]));
-            }
-        } else {
+            parsed.type = VarType::LIST;
+        } else if (names_set.size() != values.size()) {
             // names/values pairs neiter unique nor the same
             return std::nullopt;
         }
+        break;
 
-    } break;
+    default:
+        break;
     }
 
+    return parsed;
+}
+
+// creates value owning copies of the parsed parts
+URI::Template::VarValue MakeVarValue(const ParsedValue& parsed, bool sort_keys)
+{
+    using URI::Template::VarType;
+
+    URI::Template::VarValue var_value(parsed.type);
+    switch (parsed.type) {
+    case VarType::STRING:
+        var_value.Get<std::string>() = parsed.values.front();
+        break;
+
+    case VarType::LIST: {
+        auto& list = var_value.Get<std::vector<std::string>>();
+        list.reserve(parsed.values.size());
+        for (const auto value : parsed.values) {
+            list.emplace_back(value);
+        }
+    } break;
+
+    case VarType::DICT: {
+        // keys are known to be unique
+        auto& dict = var_value.Get<URI::Template::VarDict>();
+        dict.reserve(parsed.names.size());
+        for (std::size_t i = 0; i < parsed.names.size(); ++i) {
+            dict.AppendUnique(std::string(parsed.names[i]), std::string(parsed.values[i]));
+        }
+        if (sort_keys) {
+            dict.SortKeys();
+        }
+    } break;
+
+    default:
+        break;
+    }
     return var_value;
 }
 
-std::optional<URI::Template::Match> URI::Template::MatchExpression(const Expression& expression,
-                                                                   const std::string& where, std::size_t start,
-                                                                   std::size_t end, char terminator,
-                                                                   std::unordered_map<std::string, VarValue>* values)
+// allocates an array of trivial objects in the memory resource
+template <class T>
+T* AllocateArray(std::pmr::memory_resource* resource, std::size_t size)
+{
+    if (size == 0) {
+        return nullptr;
+    }
+    return static_cast<T*>(resource->allocate(size * sizeof(T), alignof(T)));
+}
+
+// copies the string into the memory resource
+std::string_view CopyString(std::pmr::memory_resource* resource, std::string_view str)
+{
+    auto* data = AllocateArray<char>(resource, str.size());
+    if (data != nullptr) {
+        std::memcpy(data, str.data(), str.size());
+    }
+    return {data, str.size()};
+}
+
+// creates view of the parsed parts, which are views of the matched string in the memory resource already
+URI::Template::VarValueView MakeVarValueView(const ParsedValue& parsed, bool sort_keys,
+                                             std::pmr::memory_resource* resource)
+{
+    using URI::Template::VarType;
+    using URI::Template::VarValueView;
+
+    switch (parsed.type) {
+    case VarType::STRING:
+        return parsed.values.front();
+
+    case VarType::LIST: {
+        auto* items = AllocateArray<std::string_view>(resource, parsed.values.size());
+        for (std::size_t i = 0; i < parsed.values.size(); ++i) {
+            new (items + i) std::string_view(parsed.values[i]);
+        }
+        return VarValueView::List(items, parsed.values.size());
+    }
+
+    case VarType::DICT: {
+        auto* items = AllocateArray<VarValueView::DictItem>(resource, parsed.names.size());
+        for (std::size_t i = 0; i < parsed.names.size(); ++i) {
+            new (items + i) VarValueView::DictItem(parsed.names[i], parsed.values[i]);
+        }
+        if (sort_keys) {
+            // keys are unique, so unstable sorting doesn't need a temporary buffer and gives the same order
+            std::sort(items, items + parsed.names.size(),
+                      [](const VarValueView::DictItem& lhs, const VarValueView::DictItem& rhs) {
+                          return lhs.first < rhs.first;
+                      });
+        }
+        return VarValueView::Dict(items, parsed.names.size());
+    }
+
+    default:
+        return {};
+    }
+}
+
+// stores matched values into the map of values, if any
+class MapStore
 {
+public:
+    MapStore(std::unordered_map<std::string, URI::Template::VarValue>* values, bool sort_keys)
+        : values_(values)
+        , sort_keys_(sort_keys)
+    {
+    }
+
+    bool Store(const URI::Template::Variable& var, const URI::Template::Operator& oper,
+               std::optional<std::string_view> where)
+    {
+        const auto parsed = ParseVarValue(var, oper, where, std::pmr::new_delete_resource());
+        if (!parsed) {
+            return false;
+        }
+        if (values_ != nullptr) {
+            values_->insert_or_assign(var.Name(), MakeVarValue(*parsed, sort_keys_));
+        }
+        return true;
+    }
+
+    void StoreUndefined(const URI::Template::Variable& var)
+    {
+        if (values_ != nullptr) {
+            values_->emplace(var.Name(), URI::Template::VarValue(URI::Template::VarType::UNDEFINED));
+        }
+    }
+
+private:
+    std::unordered_map<std::string, URI::Template::VarValue>* values_;
+    bool sort_keys_;
+};
+
+// stores views of matched values into the map in a memory resource, the matched string is in the resource too
+class ArenaStore
+{
+public:
+    ArenaStore(std::pmr::unordered_map<std::string_view, URI::Template::VarValueView>& values, bool sort_keys)
+        : values_(values)
+        , resource_(values.get_allocator().resource())
+        , sort_keys_(sort_keys)
+    {
+    }
+
+    bool Store(const URI::Template::Variable& var, const URI::Template::Operator& oper,
+               std::optional<std::string_view> where)
+    {
+        const auto parsed = ParseVarValue(var, oper, where, resource_);
+        if (!parsed) {
+            return false;
+        }
+        auto var_value = MakeVarValueView(*parsed, sort_keys_, resource_);
+        const auto value_lookup = values_.find(var.Name());
+        if (value_lookup != values_.end()) {
+            value_lookup->second = var_value;
+        } else {
+            values_.emplace(CopyString(resource_, var.Name()), var_value);
+        }
+        return true;
+    }
+
+    void StoreUndefined(const URI::Template::Variable& var)
+    {
+        if (values_.count(var.Name()) == 0) {
+            values_.emplace(CopyString(resource_, var.Name()), URI::Template::VarValueView());
+        }
+    }
+
+private:
+    std::pmr::unordered_map<std::string_view, URI::Template::VarValueView>& values_;
+    std::pmr::memory_resource* resource_;
+    bool sort_keys_;
+};
+
+std::optional<URI::Template::Match> MatchLiteralIn(const URI::Template::Literal& literal, std::string_view where,
+                                                   std::size_t start, bool exact_start)
+{
+    if (start + literal.Size() > where.size()) {
+        // literal doesn't fit in where
+        return std::nullopt;
+    }
+
+    if (exact_start) {
+        if (!StartsWith(where, literal.String())) {
+            return std::nullopt;
+        }
+        return URI::Template::Match(start, start + literal.Size());
+    }
+
+    std::size_t m_start = where.find(literal.String(), start);
+    if (m_start == std::string::npos) {
+        return std::nullopt;
+    }
+    return URI::Template::Match(m_start, m_start + literal.Size());
+}
+
+template <class Store>
+std::optional<URI::Template::Match> MatchExpressionIn(const URI::Template::Expression& expression,
+                                                      std::string_view where, std::size_t start, std::size_t end,
+                                                      char terminator, Store& store)
+{
+    using URI::Template::Variable;
+
     if (start > end || start > where.size()) {
         // range is incorrect
         return std::nullopt;
     }
 
     std::size_t matched_vars = 0;
-    std::optional<std::string> raw_value;
+    // value is contiguous, so it's a view of where
+    std::optional<std::string_view> raw_value;
     const auto& exp_oper = expression.Oper();
     const auto& exp_vars = expression.Vars();
 
@@ -222,8 +423,8 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
     std::size_t pos = start;
     ExprParts matching = ExprParts::OPERATOR;
 
-    auto match_and_store = [&exp_vars, &exp_oper, &values](std::optional<std::string>&& raw_value,
-                                                           std::size_t& pos) -> bool {
+    auto match_and_store = [&exp_vars, &exp_oper, &store](std::optional<std::string_view> raw_value,
+                                                          std::size_t& pos) -> bool {
         if (exp_oper.Named() && raw_value && pos != exp_vars.size() - 1) {
             // if it is named, lookup for closest same-name variable,
             // variables in-between will be undefined
@@ -236,10 +437,8 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
                     found = true;
                     break;
                 }
-                if (values != nullptr) {
-                    // fill skipped with 'undefined'
-                    values->emplace(var.Name(), VarValue(VarType::UNDEFINED));
-                }
+                // fill skipped with 'undefined'
+                store.StoreUndefined(var);
 
                 ++new_pos;
             }
@@ -248,17 +447,19 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
             }
         }
 
-        const auto& variable = exp_vars[pos];
-        auto var_value = MatchVarValue(variable, exp_oper, std::move(raw_value));
-        if (!var_value) {
+        if (!store.Store(exp_vars[pos], exp_oper, raw_value)) {
             return false;
         }
-        if (values != nullptr) {
-            values->insert_or_assign(variable.Name(), std::move(*var_value));
-        }
         ++pos;
         return true;
     };
+    // appends the current character to the value
+    const auto extend_value = [&where, &raw_value, &pos]() {
+        if (!raw_value) {
+            raw_value = where.substr(pos, 0);
+        }
+        raw_value = std::string_view(raw_value->data(), raw_value->size() + 1);
+    };
 
     while (pos < where.size() && pos < end) {
         char cur_char = where[pos];
@@ -275,7 +476,7 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
                 // variables start from next char if operator expanded
                 if (exp_oper.StartExpanded()) {
                     // can't be undefined after after operator symbol
-                    raw_value = std::string();
+                    raw_value = where.substr(pos + 1, 0);
                     break;
                 }
             }
@@ -289,37 +490,35 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
             // clang-format on
             if (cur_char == terminator) {
                 // it was last variable before terminator
-                if (!match_and_store(std::move(raw_value), matched_vars)) {
+                if (!match_and_store(raw_value, matched_vars)) {
                     return std::nullopt;
                 }
+                // value of reserved operator used to be moved out, so the next variable is empty then
+                if (exp_oper.Reserved() && raw_value) {
+                    raw_value = where.substr(pos, 0);
+                }
                 terminate = true; // stop right now
             } else if (char_allowed && matched_vars == exp_vars.size() - 1) {
                 // greedy for the last variable
-                if (!raw_value) {
-                    raw_value = std::string();
-                }
-                *raw_value += cur_char;
+                extend_value();
             } else if (cur_char == exp_oper.Separator()) {
                 if (exp_vars[matched_vars].IsExploded()) {
-                    // separator is a part of composite
-                    *raw_value += cur_char;
+                    // separator is a part of composite, but doesn't start it
+                    if (raw_value) {
+                        extend_value();
+                    }
                 } else {
                     // can't be undefined before or after separator
                     if (!raw_value) {
-                        raw_value = std::string();
+                        raw_value = where.substr(pos, 0);
                     }
-                    if (!match_and_store(std::move(raw_value), matched_vars)) {
+                    if (!match_and_store(raw_value, matched_vars)) {
                         return std::nullopt;
                     }
-                    // note that a moved-from std::optional still contains a value:
-                    // https://en.cppreference.com/w/cpp/utility/optional/operator%3D
-                    raw_value->clear();
+                    raw_value = where.substr(pos + 1, 0);
                 }
             } else if (char_allowed) {
-                if (!raw_value) {
-                    raw_value = std::string();
-                }
-                *raw_value += cur_char;
+                extend_value();
             } else {
                 // character is not allowed
                 terminate = true; // stop right now
@@ -334,25 +533,32 @@ std::optional<URI::Template::Match> URI::Template::MatchExpression(const Express
     }
     // fill the last one parsed
     if (raw_value && matched_vars < exp_vars.size()) {
-        if (!match_and_store(std::move(raw_value), matched_vars)) {
+        if (!match_and_store(raw_value, matched_vars)) {
             return std::nullopt;
         }
     }
     // following variables will be undefined
-    for (; values && matched_vars < exp_vars.size(); ++matched_vars) {
-        values->emplace(exp_vars[matched_vars].Name(), VarValue(VarType::UNDEFINED));
+    for (; matched_vars < exp_vars.size(); ++matched_vars) {
+        store.StoreUndefined(exp_vars[matched_vars]);
     }
-    return Match(start, pos);
+    return URI::Template::Match(start, pos);
 }
 
-bool URI::Template::MatchURI(const Template& uri_template, const std::string& uri,
-                             std::unordered_map<std::string, VarValue>* values)
+// matches template, temporary containers are allocated from the resource
+template <class Store>
+bool MatchURIIn(const URI::Template::Template& uri_template, std::string_view uri, Store& store,
+                std::pmr::memory_resource* resource)
 {
+    using URI::Template::Expression;
+    using URI::Template::Literal;
+    using URI::Template::Match;
+    using URI::Template::PartType;
+
     if (uri_template.Size() == 0) {
         return uri.empty() ? true : false;
     }
 
-    std::vector<std::optional<Match>> matches(uri_template.Size(), std::nullopt);
+    std::pmr::vector<std::optional<Match>> matches(uri_template.Size(), std::nullopt, resource);
 
     // find all literals first
     std::size_t pos = 0;
@@ -363,7 +569,7 @@ bool URI::Template::MatchURI(const Template& uri_template, const std::string& ur
             continue;
         }
 
-        auto match = MatchLiteral(part.Get<Literal>(), uri, pos, i == 0);
+        auto match = MatchLiteralIn(part.Get<Literal>(), uri, pos, i == 0);
         if (!match) {
             return false;
         }
@@ -410,7 +616,7 @@ bool URI::Template::MatchURI(const Template& uri_template, const std::string& ur
             }
         }
 
-        auto match = MatchExpression(cur_expr, uri, pos, end, terminator, values);
+        auto match = MatchExpressionIn(cur_expr, uri, pos, end, terminator, store);
         if (!match) {
             return false;
         }
@@ -429,3 +635,132 @@ bool URI::Template::MatchURI(const Template& uri_template, const std::string& ur
 
     return true;
 }
+
+} // namespace
+
+URI::Template::Match::Match(std::size_t start, std::size_t end)
+    : start_(start)
+    , end_(end)
+{
+}
+
+std::size_t URI::Template::Match::Start() const
+{
+    return start_;
+}
+
+std::size_t URI::Template::Match::End() const
+{
+    return end_;
+}
+
+std::optional<URI::Template::Match> URI::Template::MatchLiteral(const Literal& literal, const std::string& where,
+                                                                std::size_t start, bool exact_start)
+{
+    return MatchLiteralIn(literal, where, start, exact_start);
+}
+
+std::optional<URI::Template::VarValue> URI::Template::MatchVarValue(const Variable& var, const Operator& oper,
+                                                                    std::optional<std::string>&& where, bool sort_keys)
+{
+    const auto parsed = ParseVarValue(var, oper, where, std::pmr::new_delete_resource());
+    if (!parsed) {
+        return std::nullopt;
+    }
+    return MakeVarValue(*parsed, sort_keys);
+}
+
+std::optional<URI::Template::Match> URI::Template::MatchExpression(const Expression& expression,
+                                                                   const std::string& where, std::size_t start,
+                                                                   std::size_t end, char terminator,
+                                                                   std::unordered_map<std::string, VarValue>* values,
+                                                                   bool sort_keys)
+{
+    MapStore store(values, sort_keys);
+    return MatchExpressionIn(expression, where, start, end, terminator, store);
+}
+
+bool URI::Template::MatchURI(const Template& uri_template, const std::string& uri,
+                             std::unordered_map<std::string, VarValue>* values, bool sort_keys)
+{
+    MapStore store(values, sort_keys);
+    return MatchURIIn(uri_template, uri, store, std::pmr::new_delete_resource());
+}
+
+std::optional<URI::Template::VarValue> URI::Template::ConvertVarValue(const VarValue& var_value, VarType var_type)
+{
+    if (var_value.Type() == var_type || var_value.Type() == VarType::UNDEFINED) {
+        return var_value;
+    }
+    if (var_value.Type() != VarType::STRING) {
+        return std::nullopt;
+    }
+
+    const auto& str = var_value.Get<std::string>();
+    switch (var_type) {
+    case VarType::INT64:
+        return ParseNumber<std::int64_t>(str);
+
+    case VarType::UINT64:
+        return ParseNumber<std::uint64_t>(str);
+
+    case VarType::DOUBLE:
+        return ParseNumber<double>(PctDecode(str));
+
+    case VarType::BOOL:
+        if (str == "true") {
+            return VarValue(true);
+        }
+        if (str == "false") {
+            return VarValue(false);
+        }
+        return std::nullopt;
+
+    default:
+        return std::nullopt;
+    }
+}
+
+bool URI::Template::MatchURI(const Template& uri_template, const std::string& uri,
+                             const std::unordered_map<std::string, VarType>& var_types,
+                             std::unordered_map<std::string, VarValue>* values, bool sort_keys)
+{
+    std::unordered_map<std::string, VarValue> matched;
+    if (!MatchURI(uri_template, uri, &matched, sort_keys)) {
+        return false;
+    }
+
+    for (const auto& [name, var_type] : var_types) {
+        auto matched_value = matched.find(name);
+        if (matched_value == matched.end()) {
+            continue;
+        }
+        auto converted = ConvertVarValue(matched_value->second, var_type);
+        if (!converted) {
+            // value doesn't have the requested type
+            return false;
+        }
+        matched_value->second = std::move(*converted);
+    }
+
+    if (values != nullptr) {
+        // same as the untyped overload: matched values replace existing ones, undefined don't
+        for (auto& [name, var_value] : matched) {
+            if (var_value.Type() == VarType::UNDEFINED) {
+                values->emplace(name, std::move(var_value));
+            } else {
+                values->insert_or_assign(name, std::move(var_value));
+            }
+        }
+    }
+    return true;
+}
+
+bool URI::Template::MatchURI(const Template& uri_template, const std::string& uri,
+                             std::pmr::unordered_map<std::string_view, VarValueView>& values, bool sort_keys)
+{
+    // values are views of the single copy of the uri
+    auto* resource = values.get_allocator().resource();
+    ArenaStore store(values, sort_keys);
+    return MatchURIIn(uri_template, CopyString(resource, uri), store, resource);
+}
@@ -113,6 +113,7 @@ std::size_t URI::Template::Template::Size() const
 
 std::vector<URI::Template::Part>& URI::Template::Template::Parts()
 {
+    variables_indexed_ = false;
     return parts_;
 }
 
@@ -123,6 +124,7 @@ const std::vector<URI::Template::Part>& URI::Template::Template::Parts() const
 
 URI::Template::Part& URI::Template::Template::operator[](std::size_t pos)
 {
+    variables_indexed_ = false;
     return parts_[pos];
 }
 
@@ -139,3 +141,69 @@ std::string URI::Template::Template::String() const noexcept
     }
     return result;
 }
+
+std::vector<std::string> URI::Template::Template::VariableNames() const
+{
+    if (variables_indexed_) {
+        return variable_names_;
+    }
+    std::vector<std::string> result;
+    std::unordered_set<std::string_view> seen;
+    for (const auto& part : parts_) {
+        if (part.Type() != PartType::EXPRESSION) {
+            continue;
+        }
+        for (const auto& var : part.Get<Expression>().Vars()) {
+            if (seen.insert(var.Name()).second) {
+                result.push_back(var.Name());
+            }
+        }
+    }
+    return result;
+}
+
+std::optional<std::size_t> URI::Template::Template::VariableIndex(const std::string& name) const
+{
+    if (variables_indexed_) {
+        const auto slot = variable_slots_.find(name);
+        if (slot == variable_slots_.end()) {
+            return std::nullopt;
+        }
+        return slot->second;
+    }
+    // slot is the number of distinct names before the first appearance of the name
+    std::unordered_set<std::string_view> seen;
+    for (const auto& part : parts_) {
+        if (part.Type() != PartType::EXPRESSION) {
+            continue;
+        }
+        for (const auto& var : part.Get<Expression>().Vars()) {
+            if (var.Name() == name) {
+                return seen.size();
+            }
+            seen.insert(var.Name());
+        }
+    }
+    return std::nullopt;
+}
+
+void URI::Template::Template::IndexVariables(const Part& part)
+{
+    if (!variables_indexed_) {
+        variable_names_ = VariableNames();
+        variable_slots_.clear();
+        for (std::size_t i = 0; i < variable_names_.size(); ++i) {
+            variable_slots_.emplace(variable_names_[i], i);
+        }
+        variables_indexed_ = true;
+        return;
+    }
+    if (part.Type() != PartType::EXPRESSION) {
+        return;
+    }
+    for (const auto& var : part.Get<Expression>().Vars()) {
+        if (variable_slots_.emplace(var.Name(), variable_names_.size()).second) {
+            variable_names_.push_back(var.Name());
+        }
+    }
+}
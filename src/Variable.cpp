@@ -1,5 +1,10 @@
 #include "uri-template/Variable.h"
 
+#include <algorithm>
+#include <charconv>
+#include <new>
+#include <stdexcept>
+
 /*
  * RFC6570:
  *      varname     = varchar *( ["."] varchar )
@@ -52,6 +57,219 @@ const std::unordered_set<char> URI::Template::Variable::kReservedChars = {
 };
 // clang-format on
 
+URI::Template::VarDict::VarDict(std::initializer_list<value_type> items)
+{
+    reserve(items.size());
+    for (const auto& [key, value] : items) {
+        emplace(key, value);
+    }
+}
+
+URI::Template::VarDict::VarDict(const std::unordered_map<std::string, std::string>& dict)
+{
+    std::vector<const std::pair<const std::string, std::string>*> sorted;
+    sorted.reserve(dict.size());
+    for (const auto& item : dict) {
+        sorted.push_back(&item);
+    }
+    std::sort(sorted.begin(), sorted.end(), [](const auto* lhs, const auto* rhs) { return lhs->first < rhs->first; });
+    for (const auto* item : sorted) {
+        items_.emplace_back(item->first, item->second);
+    }
+    Reindex();
+}
+
+std::size_t URI::Template::VarDict::Position(std::string_view key) const
+{
+    if (index_.empty()) {
+        return static_cast<std::size_t>(std::find_if(items_.begin(), items_.end(),
+                                                     [&key](const value_type& item) { return item.first == key; }) -
+                                        items_.begin());
+    }
+    const auto [first, last] = index_.equal_range(std::hash<std::string_view>()(key));
+    for (auto indexed = first; indexed != last; ++indexed) {
+        if (items_[indexed->second].first == key) {
+            return indexed->second;
+        }
+    }
+    return items_.size();
+}
+
+URI::Template::VarDict::iterator URI::Template::VarDict::Append(std::string&& key, std::string&& value)
+{
+    items_.emplace_back(std::move(key), std::move(value));
+    if (!index_.empty()) {
+        index_.emplace(std::hash<std::string_view>()(items_.back().first), items_.size() - 1);
+    } else if (items_.size() > kIndexThreshold) {
+        Reindex();
+    }
+    return items_.end() - 1;
+}
+
+void URI::Template::VarDict::Reindex()
+{
+    index_.clear();
+    if (items_.size() <= kIndexThreshold) {
+        return;
+    }
+    index_.reserve(items_.size());
+    for (std::size_t i = 0; i < items_.size(); ++i) {
+        index_.emplace(std::hash<std::string_view>()(items_[i].first), i);
+    }
+}
+
+URI::Template::VarDict::const_iterator URI::Template::VarDict::begin() const
+{
+    return items_.begin();
+}
+
+URI::Template::VarDict::const_iterator URI::Template::VarDict::end() const
+{
+    return items_.end();
+}
+
+URI::Template::VarDict::iterator URI::Template::VarDict::begin()
+{
+    return items_.begin();
+}
+
+URI::Template::VarDict::iterator URI::Template::VarDict::end()
+{
+    return items_.end();
+}
+
+std::size_t URI::Template::VarDict::size() const
+{
+    return items_.size();
+}
+
+bool URI::Template::VarDict::empty() const
+{
+    return items_.empty();
+}
+
+void URI::Template::VarDict::reserve(std::size_t size)
+{
+    if (size > kIndexThreshold) {
+        index_.reserve(size);
+    }
+}
+
+URI::Template::VarDict::const_iterator URI::Template::VarDict::find(std::string_view key) const
+{
+    return items_.begin() + static_cast<std::ptrdiff_t>(Position(key));
+}
+
+URI::Template::VarDict::iterator URI::Template::VarDict::find(std::string_view key)
+{
+    return items_.begin() + static_cast<std::ptrdiff_t>(Position(key));
+}
+
+std::size_t URI::Template::VarDict::count(std::string_view key) const
+{
+    return find(key) == end() ? 0 : 1;
+}
+
+const std::string& URI::Template::VarDict::at(std::string_view key) const
+{
+    const auto item = find(key);
+    if (item == end()) {
+        throw std::out_of_range("no such key in dictionary");
+    }
+    return item->second;
+}
+
+std::string& URI::Template::VarDict::operator[](std::string_view key)
+{
+    auto item = find(key);
+    if (item == end()) {
+        item = Append(std::string(key), std::string());
+    }
+    return item->second;
+}
+
+std::pair<URI::Template::VarDict::iterator, bool> URI::Template::VarDict::emplace(std::string key, std::string value)
+{
+    auto item = find(key);
+    if (item != end()) {
+        return {item, false};
+    }
+    return {Append(std::move(key), std::move(value)), true};
+}
+
+std::pair<URI::Template::VarDict::iterator, bool> URI::Template::VarDict::insert_or_assign(std::string key,
+                                                                                          std::string value)
+{
+    auto item = find(key);
+    if (item != end()) {
+        item->second = std::move(value);
+        return {item, false};
+    }
+    return {Append(std::move(key), std::move(value)), true};
+}
+
+void URI::Template::VarDict::AppendUnique(std::string key, std::string value)
+{
+    Append(std::move(key), std::move(value));
+}
+
+std::size_t URI::Template::VarDict::erase(std::string_view key)
+{
+    const auto item = find(key);
+    if (item == end()) {
+        return 0;
+    }
+    // keys are const, so the rest of the items is copied instead of being shifted
+    std::deque<value_type> items;
+    for (auto other = items_.begin(); other != items_.end(); ++other) {
+        if (other != item) {
+            items.emplace_back(other->first, std::move(other->second));
+        }
+    }
+    items_.swap(items);
+    Reindex();
+    return 1;
+}
+
+void URI::Template::VarDict::SortKeys()
+{
+    std::vector<value_type*> sorted;
+    sorted.reserve(items_.size());
+    for (auto& item : items_) {
+        sorted.push_back(&item);
+    }
+    const auto by_key = [](const value_type* lhs, const value_type* rhs) { return lhs->first < rhs->first; };
+    if (std::is_sorted(sorted.begin(), sorted.end(), by_key)) {
+        return;
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), by_key);
+    std::deque<value_type> items;
+    for (auto* item : sorted) {
+        items.emplace_back(item->first, std::move(item->second));
+    }
+    items_.swap(items);
+    Reindex();
+}
+
+bool URI::Template::VarDict::operator==(const VarDict& rhs) const
+{
+    if (items_.size() != rhs.items_.size()) {
+        return false;
+    }
+    for (const auto& [key, value] : items_) {
+        const auto item = rhs.find(key);
+        if (item == rhs.end() || item->second != value) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool URI::Template::VarDict::operator!=(const VarDict& rhs) const
+{
+    return !(*this == rhs);
+}
+
 URI::Template::VarValue::VarValue(VarType var_type)
     : type_(var_type)
 {
@@ -59,33 +277,172 @@ URI::Template::VarValue::VarValue(VarType var_type)
     case VarType::UNDEFINED:
         break;
     case VarType::STRING:
-        value_ = std::string();
+        new (&storage_.string) std::string();
         break;
     case VarType::LIST:
-        value_ = std::vector<std::string>();
+        storage_.list = new std::vector<std::string>();
         break;
     case VarType::DICT:
-        value_ = std::unordered_map<std::string, std::string>();
+        storage_.dict = new VarDict();
+        break;
+    case VarType::INT64:
+        storage_.int64 = 0;
+        break;
+    case VarType::UINT64:
+        storage_.uint64 = 0;
+        break;
+    case VarType::DOUBLE:
+        storage_.number = 0.0;
+        break;
+    case VarType::BOOL:
+        storage_.boolean = false;
         break;
     }
 }
 
 URI::Template::VarValue::VarValue(std::string&& str_value)
     : type_(VarType::STRING)
-    , value_(std::move(str_value))
 {
+    new (&storage_.string) std::string(std::move(str_value));
 }
 
 URI::Template::VarValue::VarValue(std::vector<std::string>&& list_value)
     : type_(VarType::LIST)
-    , value_(std::move(list_value))
 {
+    storage_.list = new std::vector<std::string>(std::move(list_value));
 }
 
-URI::Template::VarValue::VarValue(std::unordered_map<std::string, std::string>&& dict_value)
+URI::Template::VarValue::VarValue(VarDict&& dict_value)
     : type_(VarType::DICT)
-    , value_(std::move(dict_value))
 {
+    storage_.dict = new VarDict(std::move(dict_value));
+}
+
+URI::Template::VarValue::VarValue(std::unordered_map<std::string, std::string>&& dict_value)
+    : VarValue(VarDict(dict_value))
+{
+}
+
+URI::Template::VarValue::VarValue(const VarValue& other)
+{
+    CopyFrom(other);
+}
+
+URI::Template::VarValue& URI::Template::VarValue::operator=(const VarValue& other)
+{
+    if (this != &other) {
+        // copy first to stay intact if copying throws
+        VarValue copy(other);
+        *this = std::move(copy);
+    }
+    return *this;
+}
+
+URI::Template::VarValue::VarValue(VarValue&& other) noexcept
+{
+    MoveFrom(other);
+}
+
+URI::Template::VarValue& URI::Template::VarValue::operator=(VarValue&& other) noexcept
+{
+    if (this != &other) {
+        Destroy();
+        MoveFrom(other);
+    }
+    return *this;
+}
+
+URI::Template::VarValue::~VarValue()
+{
+    Destroy();
+}
+
+void URI::Template::VarValue::CopyFrom(const VarValue& other)
+{
+    switch (other.type_) {
+    case VarType::UNDEFINED:
+        break;
+    case VarType::STRING:
+        new (&storage_.string) std::string(other.storage_.string);
+        break;
+    case VarType::LIST:
+        storage_.list = new std::vector<std::string>(*other.storage_.list);
+        break;
+    case VarType::DICT:
+        storage_.dict = new VarDict(*other.storage_.dict);
+        break;
+    case VarType::INT64:
+        storage_.int64 = other.storage_.int64;
+        break;
+    case VarType::UINT64:
+        storage_.uint64 = other.storage_.uint64;
+        break;
+    case VarType::DOUBLE:
+        storage_.number = other.storage_.number;
+        break;
+    case VarType::BOOL:
+        storage_.boolean = other.storage_.boolean;
+        break;
+    }
+    type_ = other.type_;
+    pre_encoded_ = other.pre_encoded_;
+}
+
+void URI::Template::VarValue::MoveFrom(VarValue& other) noexcept
+{
+    switch (other.type_) {
+    case VarType::UNDEFINED:
+        break;
+    case VarType::STRING:
+        new (&storage_.string) std::string(std::move(other.storage_.string));
+        other.storage_.string.~basic_string();
+        break;
+    case VarType::LIST:
+        // take ownership, other is left undefined and doesn't delete it
+        storage_.list = other.storage_.list;
+        break;
+    case VarType::DICT:
+        storage_.dict = other.storage_.dict;
+        break;
+    case VarType::INT64:
+        storage_.int64 = other.storage_.int64;
+        break;
+    case VarType::UINT64:
+        storage_.uint64 = other.storage_.uint64;
+        break;
+    case VarType::DOUBLE:
+        storage_.number = other.storage_.number;
+        break;
+    case VarType::BOOL:
+        storage_.boolean = other.storage_.boolean;
+        break;
+    }
+    type_ = other.type_;
+    pre_encoded_ = other.pre_encoded_;
+    other.type_ = VarType::UNDEFINED;
+    other.pre_encoded_ = false;
+}
+
+void URI::Template::VarValue::Destroy() noexcept
+{
+    switch (type_) {
+    case VarType::STRING:
+        storage_.string.~basic_string();
+        break;
+    case VarType::LIST:
+        delete storage_.list;
+        break;
+    case VarType::DICT:
+        delete storage_.dict;
+        break;
+    case VarType::UNDEFINED:
+    case VarType::INT64:
+    case VarType::UINT64:
+    case VarType::DOUBLE:
+    case VarType::BOOL:
+        break;
+    }
+    type_ = VarType::UNDEFINED;
 }
 
 URI::Template::VarType URI::Template::VarValue::Type() const
@@ -93,6 +450,16 @@ URI::Template::VarType URI::Template::VarValue::Type() const
     return type_;
 }
 
+void URI::Template::VarValue::SetPreEncoded(bool pre_encoded)
+{
+    pre_encoded_ = pre_encoded;
+}
+
+bool URI::Template::VarValue::IsPreEncoded() const
+{
+    return pre_encoded_;
+}
+
 std::string URI::Template::VarValue::Print() const
 {
     std::string result;
@@ -120,7 +487,7 @@ std::string URI::Template::VarValue::Print() const
         break;
     case VarType::DICT:
         result = "{";
-        for (const auto& [key, value] : Get<std::unordered_map<std::string, std::string>>()) {
+        for (const auto& [key, value] : Get<VarDict>()) {
             result += "'" + key + "': '" + value + "', ";
         }
         if (result.size() > 1) {
@@ -130,6 +497,24 @@ std::string URI::Template::VarValue::Print() const
         }
         result += "}";
         break;
+
+    case VarType::INT64:
+        result = std::to_string(Get<std::int64_t>());
+        break;
+
+    case VarType::UINT64:
+        result = std::to_string(Get<std::uint64_t>());
+        break;
+
+    case VarType::DOUBLE: {
+        char buffer[32];
+        const auto formatted = std::to_chars(buffer, buffer + sizeof(buffer), Get<double>());
+        result.assign(buffer, formatted.ptr);
+    } break;
+
+    case VarType::BOOL:
+        result = Get<bool>() ? "true" : "false";
+        break;
     }
 
     return result;
@@ -137,7 +522,29 @@ std::string URI::Template::VarValue::Print() const
 
 bool URI::Template::VarValue::operator==(const VarValue& rhs) const
 {
-    return type_ == rhs.type_ && value_ == rhs.value_;
+    if (type_ != rhs.type_) {
+        return false;
+    }
+
+    switch (type_) {
+    case VarType::UNDEFINED:
+        return true;
+    case VarType::STRING:
+        return storage_.string == rhs.storage_.string;
+    case VarType::LIST:
+        return *storage_.list == *rhs.storage_.list;
+    case VarType::DICT:
+        return *storage_.dict == *rhs.storage_.dict;
+    case VarType::INT64:
+        return storage_.int64 == rhs.storage_.int64;
+    case VarType::UINT64:
+        return storage_.uint64 == rhs.storage_.uint64;
+    case VarType::DOUBLE:
+        return storage_.number == rhs.storage_.number;
+    case VarType::BOOL:
+        return storage_.boolean == rhs.storage_.boolean;
+    }
+    return false;
 }
 
 bool URI::Template::VarValue::operator!=(const VarValue& rhs) const
@@ -145,6 +552,59 @@ bool URI::Template::VarValue::operator!=(const VarValue& rhs) const
     return !(*this == rhs);
 }
 
+URI::Template::VarValueView::VarValueView(std::string_view str_value)
+    : type_(VarType::STRING)
+    , value_(str_value)
+{
+}
+
+URI::Template::VarValueView::VarValueView(const char* str_value)
+    : VarValueView(std::string_view(str_value))
+{
+}
+
+URI::Template::VarValueView::VarValueView(const std::string& str_value)
+    : VarValueView(std::string_view(str_value))
+{
+}
+
+URI::Template::VarValueView::VarValueView(List list_value)
+    : type_(VarType::LIST)
+    , value_(list_value)
+{
+}
+
+URI::Template::VarValueView::VarValueView(const std::vector<std::string_view>& list_value)
+    : VarValueView(List(list_value))
+{
+}
+
+URI::Template::VarValueView::VarValueView(Dict dict_value)
+    : type_(VarType::DICT)
+    , value_(dict_value)
+{
+}
+
+URI::Template::VarValueView::VarValueView(const std::vector<DictItem>& dict_value)
+    : VarValueView(Dict(dict_value))
+{
+}
+
+URI::Template::VarType URI::Template::VarValueView::Type() const
+{
+    return type_;
+}
+
+void URI::Template::VarValueView::SetPreEncoded(bool pre_encoded)
+{
+    pre_encoded_ = pre_encoded;
+}
+
+bool URI::Template::VarValueView::IsPreEncoded() const
+{
+    return pre_encoded_;
+}
+
 URI::Template::Variable::Variable(std::string&& name, std::shared_ptr<Modifier>&& modifier, unsigned length)
     : name_(std::move(name))
     , modifier_(std::move(modifier))
@@ -266,7 +266,7 @@ TEST(ValueString, Test)
     ASSERT_EQ(value1, value2);
 
     ASSERT_THROW(value2.Get<std::vector<std::string>>(), std::bad_variant_access);
-    ASSERT_THROW((value2.Get<std::unordered_map<std::string, std::string>>()), std::bad_variant_access);
+    ASSERT_THROW((value2.Get<URI::Template::VarDict>()), std::bad_variant_access);
 }
 
 TEST(ValueList, Test)
@@ -282,20 +282,18 @@ TEST(ValueList, Test)
     ASSERT_EQ(value1, value2);
 
     ASSERT_THROW(value2.Get<std::string>(), std::bad_variant_access);
-    ASSERT_THROW((value2.Get<std::unordered_map<std::string, std::string>>()), std::bad_variant_access);
+    ASSERT_THROW((value2.Get<URI::Template::VarDict>()), std::bad_variant_access);
 }
 
 TEST(ValueDict, Test)
 {
     auto value1 = URI::Template::VarValue(URI::Template::VarType::DICT);
     ASSERT_EQ(value1.Type(), URI::Template::VarType::DICT);
-    ASSERT_EQ((value1.Get<std::unordered_map<std::string, std::string>>()),
-              (std::unordered_map<std::string, std::string>()));
+    ASSERT_EQ(value1.Get<URI::Template::VarDict>(), URI::Template::VarDict());
 
     auto value2 = URI::Template::VarValue(std::unordered_map<std::string, std::string>());
     ASSERT_EQ(value2.Type(), URI::Template::VarType::DICT);
-    ASSERT_EQ((value1.Get<std::unordered_map<std::string, std::string>>()),
-              (std::unordered_map<std::string, std::string>()));
+    ASSERT_EQ(value1.Get<URI::Template::VarDict>(), URI::Template::VarDict());
 
     ASSERT_EQ(value1, value2);
 
@@ -303,6 +301,123 @@ TEST(ValueDict, Test)
     ASSERT_THROW(value2.Get<std::vector<std::string>>(), std::bad_variant_access);
 }
 
+TEST(VarDict, Test)
+{
+    URI::Template::VarDict dict = {{"b", "1"}, {"a", "2"}, {"b", "3"}};
+    ASSERT_EQ(dict.size(), 2);
+    ASSERT_EQ(dict.begin()->first, "b");
+    ASSERT_EQ(dict.at("b"), "1");
+    ASSERT_THROW(dict.at("c"), std::out_of_range);
+
+    dict["c"] = "4";
+    ASSERT_FALSE(dict.emplace("a", "5").second);
+    ASSERT_FALSE(dict.insert_or_assign("a", "5").second);
+    ASSERT_EQ(dict.at("a"), "5");
+    ASSERT_EQ(dict.count("c"), 1);
+    ASSERT_EQ(dict.erase("b"), 1);
+    ASSERT_EQ(dict.erase("b"), 0);
+
+    std::vector<std::string> keys;
+    for (const auto& [key, value] : dict) {
+        keys.push_back(key);
+    }
+    ASSERT_EQ(keys, (std::vector<std::string>{"a", "c"}));
+
+    URI::Template::VarDict other = {{"c", "4"}, {"a", "5"}};
+    ASSERT_EQ(dict, other);
+    other.SortKeys();
+    ASSERT_EQ(other.begin()->first, "a");
+
+    const URI::Template::VarValue value(std::unordered_map<std::string, std::string>{{"z", ""}, {"x", ""}, {"y", ""}});
+    ASSERT_EQ(value.Print(), "{'x': '', 'y': '', 'z': ''}");
+
+    // large dictionaries are indexed
+    URI::Template::VarDict large;
+    URI::Template::VarDict reversed;
+    for (int i = 0; i < 1000; ++i) {
+        large[std::to_string(i)] = std::to_string(i);
+        reversed.AppendUnique(std::to_string(999 - i), std::to_string(999 - i));
+    }
+    ASSERT_EQ(large.size(), 1000);
+    ASSERT_FALSE(large.emplace("500", "x").second);
+    ASSERT_EQ(large.at("999"), "999");
+    ASSERT_EQ(large, reversed);
+    ASSERT_EQ(large.erase("0"), 1);
+    ASSERT_EQ(large.at("1"), "1");
+    ASSERT_EQ(large.count("0"), 0);
+    ASSERT_NE(large, reversed);
+    reversed.SortKeys();
+    ASSERT_EQ(reversed.begin()->first, "0");
+    ASSERT_EQ(reversed.at("10"), "10");
+    while (large.size() > 1) {
+        ASSERT_EQ(large.erase(large.begin()->first), 1);
+    }
+    ASSERT_EQ(large.at("999"), "999");
+
+    // keys can't be changed through iterators, so the index stays valid
+    static_assert(std::is_const_v<decltype(std::declval<URI::Template::VarDict::iterator>()->first)>);
+    for (auto& [key, value] : reversed) {
+        value = key + "!";
+    }
+    ASSERT_EQ(reversed.at("10"), "10!");
+}
+
+TEST(VarDictLegacy, Test)
+{
+    // deprecated accessor returns a copy of the dictionary
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+    URI::Template::VarValue value(URI::Template::VarDict{{"b", "1"}, {"a", "2"}});
+    const std::unordered_map<std::string, std::string> legacy =
+        value.Get<std::unordered_map<std::string, std::string>>();
+    ASSERT_EQ(legacy, (std::unordered_map<std::string, std::string>{{"a", "2"}, {"b", "1"}}));
+    ASSERT_THROW((URI::Template::VarValue("str").Get<std::unordered_map<std::string, std::string>>()),
+                 std::bad_variant_access);
+#pragma GCC diagnostic pop
+}
+
+TEST(ValueStorage, Test)
+{
+    ASSERT_LE(sizeof(URI::Template::VarValue), sizeof(std::string) + 8);
+
+    std::vector<URI::Template::VarValue> values = {
+        URI::Template::VarValue(),
+        URI::Template::VarValue("short"),
+        URI::Template::VarValue(std::string(100, 'x')),
+        URI::Template::VarValue(std::vector<std::string>{"a", "b"}),
+        URI::Template::VarValue(URI::Template::VarDict{{"k", "v"}}),
+        URI::Template::VarValue(-1),
+        URI::Template::VarValue(1u),
+        URI::Template::VarValue(0.5),
+        URI::Template::VarValue(true),
+    };
+    values[1].SetPreEncoded();
+
+    for (const auto& value : values) {
+        URI::Template::VarValue copy(value);
+        ASSERT_EQ(copy, value);
+        ASSERT_EQ(copy.IsPreEncoded(), value.IsPreEncoded());
+
+        URI::Template::VarValue moved(std::move(copy));
+        ASSERT_EQ(moved, value);
+        ASSERT_EQ(copy.Type(), URI::Template::VarType::UNDEFINED);
+
+        for (const auto& other : values) {
+            URI::Template::VarValue assigned(other);
+            assigned = value;
+            ASSERT_EQ(assigned, value);
+            assigned = URI::Template::VarValue(other);
+            ASSERT_EQ(assigned, other);
+        }
+    }
+
+    auto& self = values[4];
+    self = values[4];
+    ASSERT_EQ(self.Get<URI::Template::VarDict>().at("k"), "v");
+    ASSERT_THROW(values[5].Get<std::uint64_t>(), std::bad_variant_access);
+    ASSERT_NE(values[5], values[6]);
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
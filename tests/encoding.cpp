@@ -0,0 +1,175 @@
+#include "../src/Encoding.h"
+#include "fixtures.h"
+
+#include <iomanip>
+#include <random>
+#include <sstream>
+
+namespace {
+
+// Reference percent-encoding implementation, character by character
+std::string ReferencePctEncode(const std::string& value, bool allow_reserved, std::size_t max_len)
+{
+    std::ostringstream encoded;
+    encoded.fill('0');
+    encoded << std::hex;
+    if (max_len > value.size()) {
+        max_len = value.size();
+    }
+
+    auto is_hex = [](char c) { return std::isxdigit(static_cast<unsigned char>(c)) != 0; };
+    for (std::size_t i = 0; i < max_len; ++i) {
+        const auto& c = value[i];
+        if (c == '%' && i + 2 < max_len && is_hex(value[i + 1]) && is_hex(value[i + 2])) {
+            encoded << c;
+            if (max_len + 2 <= value.size()) {
+                max_len += 2;
+            }
+            continue;
+        }
+        if (c != '%' && c != ',' && URI::Template::Variable::kValueChars.count(c)) {
+            encoded << c;
+            continue;
+        }
+        if (allow_reserved && URI::Template::Variable::kReservedChars.count(c)) {
+            encoded << c;
+            continue;
+        }
+        encoded << std::uppercase;
+        encoded << '%' << std::setw(2) << int((unsigned char)c);
+        encoded << std::nouppercase;
+    }
+
+    return encoded.str();
+}
+
+// Random strings biased to long clean runs with rare special characters
+std::string RandomValue(std::mt19937& rng)
+{
+    static const std::string kClean = "abcXYZ0189-._~";
+    static const std::string kSpecial = "%%%aF,/?#[]!$&'()*+;=:@ \"<>\\^`{|}\x7F\x80\xFF";
+
+    std::string value(rng() % 100, '\0');
+    for (auto& c : value) {
+        switch (rng() % 8) {
+        case 0:
+            c = kSpecial[rng() % kSpecial.size()];
+            break;
+        case 1:
+            c = static_cast<char>(rng() % 256);
+            break;
+        default:
+            c = kClean[rng() % kClean.size()];
+        }
+    }
+    return value;
+}
+
+} // namespace
+
+TEST(PctEncodeDifferential, Test)
+{
+    std::mt19937 rng(6570);
+    for (int i = 0; i < 100000; ++i) {
+        const std::string value = RandomValue(rng);
+        const bool allow_reserved = rng() % 2;
+        const std::size_t max_len = rng() % 4 ? std::numeric_limits<std::size_t>::max() : rng() % 100;
+
+        ASSERT_EQ(URI::Template::PctEncode(value, allow_reserved, max_len),
+                  ReferencePctEncode(value, allow_reserved, max_len))
+            << "value: '" << value << "', allow_reserved: " << allow_reserved << ", max_len: " << max_len;
+    }
+}
+
+TEST(CleanPrefixKernels, Test)
+{
+    std::vector<URI::Template::detail::CleanPrefixFn> kernels = {URI::Template::detail::CleanPrefix};
+#ifdef URITEMPLATE_X86_64
+    kernels.push_back(URI::Template::detail::CleanPrefixSse2);
+    if (URI::Template::detail::HasAvx2()) {
+        kernels.push_back(URI::Template::detail::CleanPrefixAvx2);
+    }
+#endif
+
+    std::mt19937 rng(3986);
+    for (int i = 0; i < 100000; ++i) {
+        const std::string value = RandomValue(rng);
+        const bool allow_reserved = rng() % 2;
+        const std::size_t expected =
+            URI::Template::detail::CleanPrefixScalar(value.data(), value.size(), allow_reserved);
+        for (const auto& kernel : kernels) {
+            ASSERT_EQ(kernel(value.data(), value.size(), allow_reserved), expected) << "value: '" << value << "'";
+        }
+    }
+
+    // every single byte value at every position of a vector
+    for (int c = 0; c < 256; ++c) {
+        for (std::size_t pos = 0; pos < 40; ++pos) {
+            std::string value(40, 'a');
+            value[pos] = static_cast<char>(c);
+            for (bool allow_reserved : {false, true}) {
+                const std::size_t expected =
+                    URI::Template::detail::CleanPrefixScalar(value.data(), value.size(), allow_reserved);
+                for (const auto& kernel : kernels) {
+                    ASSERT_EQ(kernel(value.data(), value.size(), allow_reserved), expected)
+                        << "char: " << c << ", pos: " << pos;
+                }
+            }
+        }
+    }
+}
+
+TEST(WalkPctEncodeStop, Test)
+{
+    const auto encode = [](std::string_view value, bool allow_reserved, std::size_t max_len) {
+        std::string result;
+        URI::Template::detail::WalkPctEncode(
+            value, allow_reserved, max_len,
+            [&result, &value](std::size_t begin, std::size_t end) {
+                result.append(value.data() + begin, end - begin);
+                return true;
+            },
+            [&result](unsigned char c) {
+                result += URI::Template::PctEncode(std::string(1, static_cast<char>(c)));
+                return true;
+            });
+        return result;
+    };
+
+    // stoppable walk reports long runs in pieces, but encodes the same
+    std::mt19937 rng(1024);
+    for (int i = 0; i < 1000; ++i) {
+        std::string value = RandomValue(rng);
+        value.insert(rng() % (value.size() + 1), std::string(rng() % 20000, 'a'));
+        const bool allow_reserved = rng() % 2;
+        const std::size_t max_len = rng() % 4 ? std::numeric_limits<std::size_t>::max() : rng() % 10000;
+        ASSERT_EQ(encode(value, allow_reserved, max_len), URI::Template::PctEncode(value, allow_reserved, max_len));
+    }
+
+    // stops in the middle of a long run and after an escaped character
+    const std::string value = std::string(100000, 'a') + " " + std::string(100000, 'b');
+    std::size_t scanned = 0;
+    URI::Template::detail::WalkPctEncode(
+        value, false, value.size(),
+        [&scanned](std::size_t, std::size_t end) {
+            scanned = end;
+            return false;
+        },
+        [](unsigned char) { return true; });
+    ASSERT_EQ(scanned, URI::Template::detail::kWalkChunkSize);
+
+    std::size_t escapes = 0;
+    URI::Template::detail::WalkPctEncode(
+        value, false, value.size(), [](std::size_t, std::size_t) { return true; },
+        [&escapes](unsigned char) {
+            ++escapes;
+            return false;
+        });
+    ASSERT_EQ(escapes, 1);
+}
+
+int main(int argc, char** argv)
+{
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
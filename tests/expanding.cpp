@@ -1,5 +1,13 @@
 #include "fixtures.h"
 
+#include <cstring>
+#include <thread>
+
+#ifdef __unix__
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
 TEST_P(TemplateExpand, Test)
 {
     ASSERT_TRUE(Expanded(GetParam()));
@@ -402,6 +410,780 @@ INSTANTIATE_TEST_CASE_P(
 );
 // clang-format on
 
+TEST(PctEncode, Test)
+{
+    ASSERT_EQ(URI::Template::PctEncode("value"), "value");
+    ASSERT_EQ(URI::Template::PctEncode("Hello World!"), "Hello%20World%21");
+    ASSERT_EQ(URI::Template::PctEncode("Hello World!", true), "Hello%20World!");
+    ASSERT_EQ(URI::Template::PctEncode("a,b"), "a%2Cb");
+    ASSERT_EQ(URI::Template::PctEncode("a,b", true), "a,b");
+    ASSERT_EQ(URI::Template::PctEncode("dr\xC3\xBC" "cken"), "dr%C3%BCcken");
+    ASSERT_EQ(URI::Template::PctEncode("%41%zz%4"), "%41%25zz%254");
+    ASSERT_EQ(URI::Template::PctEncode("value", false, 3), "val");
+    ASSERT_EQ(URI::Template::PctEncode("%41bc", false, 3), "%41bc");
+    ASSERT_EQ(URI::Template::PctEncode("a b", false, 2), "a%20");
+
+    std::string result = "x=";
+    URI::Template::PctEncode("a b", result);
+    URI::Template::PctEncode("/c", result, true);
+    ASSERT_EQ(result, "x=a%20b/c");
+}
+
+struct VectorSink
+{
+    void append(const char* data, std::size_t size)
+    {
+        buffer.insert(buffer.end(), data, data + size);
+    }
+
+    void push_back(char c)
+    {
+        buffer.push_back(c);
+    }
+
+    std::vector<char> buffer;
+};
+
+TEST(ExpandIntoSink, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/user{/id}{?token,tab}{&keys*}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("admin")},
+        {"token", URI::Template::VarValue("12 45")},
+        {"keys", URI::Template::VarValue(std::unordered_map<std::string, std::string>{{"key1", "val1"}})},
+    };
+    const std::string expected = "/user/admin?token=12%2045&key1=val1";
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expected);
+
+    std::string result = "http://example.com";
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    ASSERT_EQ(result, "http://example.com" + expected);
+
+    result.clear();
+    URI::Template::ExpandExpression(uri_template[1].Get<URI::Template::Expression>(), values, result);
+    URI::Template::ExpandExpression(uri_template[2].Get<URI::Template::Expression>(), values, result);
+    ASSERT_EQ(result, "/admin?token=12%2045");
+
+    VectorSink sink;
+    URI::Template::ExpandTemplate(uri_template, values, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), expected);
+
+    sink.buffer.clear();
+    URI::Template::ExpandExpression(uri_template[3].Get<URI::Template::Expression>(), values, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), "&key1=val1");
+}
+
+TEST(ExpandedSize, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/x{/list*}{?name:3,list,empty}{&keys*}");
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"list", URI::Template::VarValue(std::vector<std::string>{"a b", "%41"})},
+        {"name", URI::Template::VarValue("J\xC3\xBCrgen")},
+        {"empty", URI::Template::VarValue("")},
+        {"keys", URI::Template::VarValue(std::unordered_map<std::string, std::string>{{"k y", ""}})},
+    };
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values),
+              "/x/a%20b/%41?name=J%C3%BC&list=a%20b,%41&empty=&k%20y=");
+    ASSERT_EQ(URI::Template::ExpandedSize(uri_template, values), 54);
+
+    values.clear();
+    ASSERT_EQ(URI::Template::ExpandedSize(uri_template, values), 2);
+}
+
+TEST(CompiledExpander, Test)
+{
+    auto uri_template = URI::Template::ParseTemplate("http://example.com{/id}/pages{?page,q}");
+    uri_template.EmplaceBack(URI::Template::Literal("#"));
+    uri_template.EmplaceBack(URI::Template::Literal("top"));
+
+    const URI::Template::CompiledExpander expander(uri_template);
+    ASSERT_EQ(expander.LiteralSize(), 28);
+
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("a/b")},
+        {"page", URI::Template::VarValue("2")},
+    };
+    ASSERT_EQ(expander.Expand(values), "http://example.com/a%2Fb/pages?page=2#top");
+    ASSERT_EQ(expander.Expand(values), URI::Template::ExpandTemplate(uri_template, values));
+
+    std::string result;
+    for (const auto& page : {"3", "4"}) {
+        result.clear();
+        values["page"] = URI::Template::VarValue(page);
+        expander.Expand(values, result);
+        ASSERT_EQ(result, URI::Template::ExpandTemplate(uri_template, values));
+    }
+
+    VectorSink sink;
+    expander.Expand({}, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), "http://example.com/pages#top");
+
+    URI::Template::Template empty_expression;
+    empty_expression.EmplaceBack(URI::Template::Expression(nullptr, {}));
+    ASSERT_THROW(URI::Template::CompiledExpander{empty_expression}, std::runtime_error);
+}
+
+TEST(ExpandBoundValues, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("{/id}{/list*}{?id,page,missing}");
+    ASSERT_EQ(uri_template.VariableNames(), (std::vector<std::string>{"id", "list", "page", "missing"}));
+    ASSERT_EQ(uri_template.VariableIndex("id"), 0);
+    ASSERT_EQ(uri_template.VariableIndex("list"), 1);
+    ASSERT_EQ(uri_template.VariableIndex("page"), 2);
+    ASSERT_EQ(uri_template.VariableIndex("missing"), 3);
+    ASSERT_EQ(uri_template.VariableIndex("unknown"), std::nullopt);
+
+    // parts changed in place are taken into account
+    auto changed = uri_template;
+    changed.Parts().erase(changed.Parts().begin());
+    ASSERT_EQ(changed.VariableNames(), (std::vector<std::string>{"list", "id", "page", "missing"}));
+    ASSERT_EQ(changed.VariableIndex("id"), 1);
+    changed.EmplaceBack(URI::Template::ParseTemplate("{extra,id}")[0]);
+    ASSERT_EQ(changed.VariableIndex("id"), 1);
+    ASSERT_EQ(changed.VariableIndex("extra"), 4);
+    ASSERT_EQ(changed.VariableNames().size(), 5);
+
+    const URI::Template::CompiledExpander expander(uri_template);
+    ASSERT_EQ(expander.VariableNames(), uri_template.VariableNames());
+    for (const auto& name : uri_template.VariableNames()) {
+        ASSERT_EQ(expander.VariableIndex(name), uri_template.VariableIndex(name)) << name;
+    }
+    ASSERT_EQ(expander.VariableIndex("page"), 2);
+    ASSERT_EQ(expander.VariableIndex("unknown"), std::nullopt);
+
+    std::vector<URI::Template::VarValue> values(3);
+    values[*expander.VariableIndex("id")] = URI::Template::VarValue("a b");
+    values[*expander.VariableIndex("list")] = URI::Template::VarValue(std::vector<std::string>{"x", "y"});
+    ASSERT_EQ(expander.Expand(values), "/a%20b/x/y?id=a%20b");
+
+    values[*expander.VariableIndex("page")] = URI::Template::VarValue("2");
+    std::string result;
+    expander.Expand(values, result);
+    ASSERT_EQ(result, "/a%20b/x/y?id=a%20b&page=2");
+
+    const std::array<URI::Template::VarValue, 1> id_only = {URI::Template::VarValue("1")};
+    VectorSink sink;
+    expander.Expand(id_only, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), "/1?id=1");
+
+    ASSERT_EQ(expander.Expand(URI::Template::BoundValues(nullptr, 0)), "");
+}
+
+TEST(ExpandValueViews, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("{/id}{/list*}{?q,list}{&keys*}");
+    const std::string buffer = "id=a/b&q=x y";
+    const std::vector<std::string_view> list = {"a b", "%41"};
+    const std::vector<URI::Template::VarValueView::DictItem> keys = {{"k1", "v1"}, {"k2", ""}};
+    const std::unordered_map<std::string_view, URI::Template::VarValueView> views = {
+        {"id", std::string_view(buffer).substr(3, 3)},
+        {"q", std::string_view(buffer).substr(9)},
+        {"list", list},
+        {"keys", keys},
+    };
+    const std::string expected = "/a%2Fb/a%20b/%41?q=x%20y&list=a%20b,%41&k1=v1&k2=";
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, views), expected);
+
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("a/b")},
+        {"q", URI::Template::VarValue("x y")},
+        {"list", URI::Template::VarValue(std::vector<std::string>{"a b", "%41"})},
+    };
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, views).substr(0, expected.find("&k1")),
+              URI::Template::ExpandTemplate(uri_template, values));
+
+    std::string result;
+    URI::Template::ExpandExpression(uri_template[2].Get<URI::Template::Expression>(), views, result);
+    ASSERT_EQ(result, "?q=x%20y&list=a%20b,%41");
+
+    VectorSink sink;
+    URI::Template::ExpandTemplate(uri_template, {{"id", "1"}, {"list", URI::Template::VarValueView()}}, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), "/1");
+
+    ASSERT_EQ(URI::Template::VarValueView().Type(), URI::Template::VarType::UNDEFINED);
+    ASSERT_EQ(URI::Template::VarValueView(list).Get<URI::Template::VarValueView::List>().size(), 2);
+    ASSERT_THROW(URI::Template::VarValueView(keys).Get<std::string_view>(), std::bad_variant_access);
+}
+
+TEST(ExpandResolver, Test)
+{
+    struct Context
+    {
+        std::string user;
+        int requests;
+        std::vector<std::string_view> tags;
+    };
+    const Context context = {"john doe", 0, {"a", "b"}};
+
+    std::vector<std::string> requested;
+    auto resolver = [&context, &requested](std::string_view name) -> std::optional<URI::Template::VarValueView> {
+        requested.emplace_back(name);
+        if (name == "user") {
+            return URI::Template::VarValueView(context.user);
+        }
+        if (name == "tags") {
+            return URI::Template::VarValueView(context.tags);
+        }
+        return std::nullopt;
+    };
+
+    const auto uri_template = URI::Template::ParseTemplate("/users{/user}{?tags,unknown}");
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, resolver), "/users/john%20doe?tags=a,b");
+    ASSERT_EQ(requested, (std::vector<std::string>{"user", "tags", "unknown"}));
+
+    std::string result;
+    URI::Template::ExpandExpression(uri_template[1].Get<URI::Template::Expression>(), resolver, result);
+    ASSERT_EQ(result, "/john%20doe");
+
+    VectorSink sink;
+    URI::Template::ExpandTemplate(
+        uri_template, [](std::string_view) { return std::optional<URI::Template::VarValueView>(); }, sink);
+    ASSERT_EQ(std::string(sink.buffer.begin(), sink.buffer.end()), "/users");
+}
+
+TEST(ExpandNativeValues, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/items{/id}{?page,ratio,big,all}{&id:2}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue(-1234)},
+        {"page", URI::Template::VarValue(std::uint64_t(18446744073709551615u))},
+        {"ratio", URI::Template::VarValue(0.25)},
+        {"big", URI::Template::VarValue(1e300)},
+        {"all", URI::Template::VarValue(true)},
+    };
+    ASSERT_EQ(values.at("id").Type(), URI::Template::VarType::INT64);
+    ASSERT_EQ(values.at("page").Type(), URI::Template::VarType::UINT64);
+    ASSERT_EQ(values.at("ratio").Type(), URI::Template::VarType::DOUBLE);
+    ASSERT_EQ(values.at("all").Type(), URI::Template::VarType::BOOL);
+    ASSERT_EQ(URI::Template::VarValue("true").Type(), URI::Template::VarType::STRING);
+    ASSERT_EQ(values.at("big").Print(), "1e+300");
+
+    const std::string expected = "/items/-1234?page=18446744073709551615&ratio=0.25&big=1e%2B300&all=true&id=-1";
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expected);
+    ASSERT_EQ(URI::Template::ExpandedSize(uri_template, values), expected.size());
+
+    const std::unordered_map<std::string_view, URI::Template::VarValueView> views = {
+        {"id", -1234}, {"page", 18446744073709551615u}, {"ratio", 0.25f}, {"big", 1e300}, {"all", true}};
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, views), expected);
+}
+
+TEST(ExpandPreEncoded, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/files{/id}{?path,tags}{#frag}");
+    URI::Template::VarValue id("3f2c%2Fa-b");
+    id.SetPreEncoded();
+    URI::Template::VarValue tags(std::vector<std::string>{"a", "b%20c"});
+    tags.SetPreEncoded();
+    URI::Template::VarValue frag("sec/1?x");
+    frag.SetPreEncoded();
+    ASSERT_TRUE(id.IsPreEncoded());
+    ASSERT_EQ(id, URI::Template::VarValue("3f2c%2Fa-b"));
+
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", id},
+        {"path", URI::Template::VarValue("a/b")},
+        {"tags", tags},
+        {"frag", frag},
+    };
+    const std::string expected = "/files/3f2c%2Fa-b?path=a%2Fb&tags=a,b%20c#sec/1?x";
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expected);
+    ASSERT_EQ(URI::Template::ExpandedSize(uri_template, values), expected.size());
+
+    // the same result as encoding
+    for (auto& [name, var_value] : values) {
+        var_value.SetPreEncoded(false);
+    }
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expected);
+
+    URI::Template::VarValueView view("abc%41");
+    view.SetPreEncoded();
+    ASSERT_EQ(URI::Template::ExpandTemplate(URI::Template::ParseTemplate("{v}{/v:2}"), {{"v", view}}), "abc%41/ab");
+
+#ifndef NDEBUG
+    URI::Template::VarValue unsafe("a b");
+    unsafe.SetPreEncoded();
+    ASSERT_DEATH(URI::Template::ExpandTemplate(uri_template, {{"id", unsafe}}), "pre-encoded");
+#endif
+}
+
+TEST(ExpansionCache, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/users{/id}{?fields}");
+    URI::Template::ExpansionCache cache(2, 1);
+
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("a b")},
+        {"other", URI::Template::VarValue("x")},
+    };
+    const auto first = cache.Expand(uri_template, values);
+    ASSERT_EQ(*first, "/users/a%20b");
+    ASSERT_EQ(cache.Misses(), 1);
+
+    // values which are not in the template don't affect the key
+    values["other"] = URI::Template::VarValue("y");
+    ASSERT_EQ(cache.Expand(uri_template, values), first);
+    ASSERT_EQ(cache.Hits(), 1);
+
+    // dicts with the same items in different order expand differently
+    values["fields"] = URI::Template::VarValue(URI::Template::VarDict{{"a", "1"}, {"b", "2"}});
+    ASSERT_EQ(*cache.Expand(uri_template, values), "/users/a%20b?fields=a,1,b,2");
+    values["fields"] = URI::Template::VarValue(URI::Template::VarDict{{"b", "2"}, {"a", "1"}});
+    ASSERT_EQ(*cache.Expand(uri_template, values), "/users/a%20b?fields=b,2,a,1");
+    ASSERT_EQ(cache.Misses(), 3);
+    ASSERT_EQ(cache.Evictions(), 1);
+    ASSERT_EQ(cache.Size(), 2);
+
+    // the first result was the least recently used one
+    values.erase("fields");
+    ASSERT_NE(cache.Expand(uri_template, values), first);
+    ASSERT_EQ(*first, "/users/a%20b");
+    ASSERT_EQ(cache.Misses(), 4);
+
+    cache.Clear();
+    ASSERT_EQ(cache.Size(), 0);
+    ASSERT_THROW(URI::Template::ExpansionCache(1, 0), std::invalid_argument);
+
+    URI::Template::ExpansionCache shared_cache(64);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&shared_cache, &uri_template] {
+            for (int i = 0; i < 1000; ++i) {
+                const std::unordered_map<std::string, URI::Template::VarValue> thread_values = {
+                    {"id", URI::Template::VarValue(std::to_string(i % 100))}};
+                ASSERT_EQ(*shared_cache.Expand(uri_template, thread_values), "/users/" + std::to_string(i % 100));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    ASSERT_EQ(shared_cache.Hits() + shared_cache.Misses(), 4000);
+    ASSERT_LE(shared_cache.Size(), 64);
+
+    // capacity is kept exactly when it's not a multiple of the number of shards
+    for (const std::size_t capacity : {0, 1, 10, 35}) {
+        URI::Template::ExpansionCache small_cache(capacity);
+        for (int i = 0; i < 1000; ++i) {
+            const std::unordered_map<std::string, URI::Template::VarValue> small_values = {
+                {"id", URI::Template::VarValue(std::to_string(i))}};
+            ASSERT_EQ(*small_cache.Expand(uri_template, small_values), "/users/" + std::to_string(i));
+        }
+        ASSERT_EQ(small_cache.Size(), capacity);
+    }
+}
+
+TEST(ExpansionState, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/search{?q,page}{&page,size}#{page}-end");
+    URI::Template::ExpansionState state(uri_template, {{"q", URI::Template::VarValue("a b")}});
+    ASSERT_EQ(state.String(), "/search?q=a%20b#-end");
+
+    for (const auto& page : {"1", "22", "", "3/4"}) {
+        state.Update("page", URI::Template::VarValue(page));
+        ASSERT_EQ(state.String(), URI::Template::ExpandTemplate(uri_template, state.Values()));
+    }
+    ASSERT_EQ(state.String(), "/search?q=a%20b&page=3%2F4&page=3%2F4#3%2F4-end");
+
+    state.Update("q", URI::Template::VarValue());
+    state.Update("size", URI::Template::VarValue(10));
+    state.Update("missing", URI::Template::VarValue("x"));
+    ASSERT_EQ(state.String(), "/search?page=3%2F4&page=3%2F4&size=10#3%2F4-end");
+    ASSERT_EQ(state.Values().size(), 4);
+}
+
+TEST(ExpansionHash, Test)
+{
+    // reference XXH64 values
+    ASSERT_EQ(URI::Template::HashString(""), 0xEF46DB3751D8E999ULL);
+    ASSERT_EQ(URI::Template::HashString("abc"), 0x44BC2CF5AD770999ULL);
+    ASSERT_EQ(URI::Template::HashString("http://example.com/a%20b?x=1&y=zzzzzzzzzzzzzzzzzzzzzzzzzzzzz", 42),
+              0xE5294C167D8E6059ULL);
+
+    const auto uri_template = URI::Template::ParseTemplate("http://example.com{/path*}{?q,n}{&dict*}{#frag}");
+    std::unordered_map<std::string, URI::Template::VarValue> values;
+    ASSERT_EQ(URI::Template::ExpansionHash(uri_template, values), URI::Template::HashString("http://example.com"));
+
+    // expansions of different sizes exercise partial and whole stripes
+    std::string path;
+    for (int i = 0; i < 40; ++i) {
+        path += static_cast<char>('a' + i % 26);
+        path += i % 3 ? "" : " ";
+        values["path"] = URI::Template::VarValue(std::vector<std::string>{path, "x/y"});
+        values["q"] = URI::Template::VarValue(std::string(path));
+        values["n"] = URI::Template::VarValue(i);
+        values["dict"] = URI::Template::VarValue(URI::Template::VarDict{{"k", path}});
+        values["frag"] = URI::Template::VarValue(path.substr(i / 2));
+        const std::string expanded = URI::Template::ExpandTemplate(uri_template, values);
+        for (std::uint64_t seed : {0ULL, 1ULL, 0xFFFFFFFFFFFFFFFFULL}) {
+            ASSERT_EQ(URI::Template::ExpansionHash(uri_template, values, seed),
+                      URI::Template::HashString(expanded, seed))
+                << expanded;
+        }
+    }
+}
+
+TEST(ExpansionEquals, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("https://example.com/files{/id}{?list,dict*}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("a b")},
+        {"list", URI::Template::VarValue(std::vector<std::string>{"x", "y"})},
+        {"dict", URI::Template::VarValue(URI::Template::VarDict{{"k", "v"}, {"sig", "0f/a"}})},
+    };
+    const std::string expanded = "https://example.com/files/a%20b?list=x,y&k=v&sig=0f%2Fa";
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expanded);
+    ASSERT_TRUE(URI::Template::ExpansionEquals(uri_template, values, expanded));
+
+    // every prefix, extension and single character change
+    for (std::size_t i = 0; i < expanded.size(); ++i) {
+        ASSERT_FALSE(URI::Template::ExpansionEquals(uri_template, values, expanded.substr(0, i)));
+        std::string changed = expanded;
+        changed[i] = changed[i] == 'Z' ? 'z' : 'Z';
+        ASSERT_FALSE(URI::Template::ExpansionEquals(uri_template, values, changed)) << changed;
+    }
+    ASSERT_FALSE(URI::Template::ExpansionEquals(uri_template, values, expanded + "&"));
+    ASSERT_TRUE(URI::Template::ExpansionEquals(URI::Template::ParseTemplate("{undef}"), {}, ""));
+
+    // long values, mismatches near the start, in the middle and at the end
+    const auto query = URI::Template::ParseTemplate("/search{?q,r}");
+    const std::unordered_map<std::string, URI::Template::VarValue> long_values = {
+        {"q", URI::Template::VarValue(std::string(100000, 'a') + " " + std::string(100000, 'b'))},
+        {"r", URI::Template::VarValue(std::string(10000, 'c'))},
+    };
+    const std::string long_expanded = URI::Template::ExpandTemplate(query, long_values);
+    ASSERT_TRUE(URI::Template::ExpansionEquals(query, long_values, long_expanded));
+    for (const std::size_t pos : {std::size_t(12), std::size_t(50000), std::size_t(100010), long_expanded.size() - 1}) {
+        std::string changed = long_expanded;
+        changed[pos] = 'Z';
+        ASSERT_FALSE(URI::Template::ExpansionEquals(query, long_values, changed)) << pos;
+    }
+    ASSERT_FALSE(URI::Template::ExpansionEquals(query, long_values, long_expanded.substr(0, 1000)));
+    ASSERT_FALSE(URI::Template::ExpansionEquals(query, long_values, long_expanded.substr(0, long_expanded.size() - 1)));
+    ASSERT_FALSE(URI::Template::ExpansionEquals(query, long_values, "/search?q=a"));
+}
+
+TEST(BindPartial, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("https://{host}/api/{version}{/tenant}/users{/id}{?q,fields}");
+    const std::unordered_map<std::string, URI::Template::VarValue> fixed = {
+        {"host", URI::Template::VarValue("example.com")},
+        {"version", URI::Template::VarValue("v2")},
+        {"tenant", URI::Template::VarValue("a b")},
+        {"q", URI::Template::VarValue("unused")},
+    };
+    const auto bound = URI::Template::BindPartial(uri_template, fixed);
+    ASSERT_EQ(bound.String(), "https://example.com/api/v2/a%20b/users{/id}?q=unused{&fields}");
+    ASSERT_EQ(bound.Size(), 4);
+    ASSERT_EQ(bound[0].Type(), URI::Template::PartType::LITERAL);
+
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("42")},
+        {"fields", URI::Template::VarValue(std::vector<std::string>{"name", "email"})},
+    };
+    const std::string expected = "https://example.com/api/v2/a%20b/users/42?q=unused&fields=name,email";
+    ASSERT_EQ(URI::Template::ExpandTemplate(bound, values), expected);
+    values.insert(fixed.begin(), fixed.end());
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), expected);
+
+    // partly bound expressions
+    const std::unordered_map<std::string, URI::Template::VarValue> some = {
+        {"a", URI::Template::VarValue("1")},
+        {"c", URI::Template::VarValue(std::vector<std::string>{"x", "y"})},
+        {"undef", URI::Template::VarValue()},
+        {"empty", URI::Template::VarValue(std::vector<std::string>{})},
+        {"nodict", URI::Template::VarValue(URI::Template::VarDict{})},
+    };
+    const std::unordered_map<std::string, URI::Template::VarValue> rest = {{"b", URI::Template::VarValue("2")}};
+    const std::unordered_map<std::string, URI::Template::VarValue> none;
+    std::unordered_map<std::string, URI::Template::VarValue> all = some;
+    all.insert(rest.begin(), rest.end());
+    for (const std::string str : {"{/a,b,c*}", "{.undef,b,a}", "{;b,a,c}", "{?a,c,b,undef}", "{&undef,b,c}",
+                                  "{?undef,a,b}", "{a,undef}", "{#undef,b}", "{?empty*,b}", "{?nodict*,empty,b}",
+                                  "{?empty,a,b}"}) {
+        const auto str_template = URI::Template::ParseTemplate(str);
+        const auto str_bound = URI::Template::BindPartial(str_template, some);
+        ASSERT_EQ(URI::Template::ExpandTemplate(str_bound, rest), URI::Template::ExpandTemplate(str_template, all))
+            << str;
+        ASSERT_EQ(URI::Template::ExpandTemplate(str_bound, none), URI::Template::ExpandTemplate(str_template, some))
+            << str;
+    }
+    ASSERT_EQ(URI::Template::BindPartial(URI::Template::ParseTemplate("{/a,b,c*}"), some).String(), "/1{/b}/x/y");
+    ASSERT_EQ(URI::Template::BindPartial(URI::Template::ParseTemplate("{?a,c,b}"), some).String(), "?a=1&c=x,y{&b}");
+    ASSERT_EQ(URI::Template::BindPartial(URI::Template::ParseTemplate("{#undef,b}"), some).String(), "{#b}");
+    ASSERT_EQ(URI::Template::BindPartial(URI::Template::ParseTemplate("{?empty*,b}"), some).String(), "{?b}");
+    ASSERT_THROW(URI::Template::BindPartial(URI::Template::ParseTemplate("{?empty*,b,a}"), some), std::invalid_argument);
+    ASSERT_THROW(URI::Template::BindPartial(URI::Template::ParseTemplate("{?b,a}"), some), std::invalid_argument);
+    ASSERT_THROW(URI::Template::BindPartial(URI::Template::ParseTemplate("{a,b}"), some), std::invalid_argument);
+    ASSERT_THROW(URI::Template::BindPartial(URI::Template::ParseTemplate("{+b,a}"), some), std::invalid_argument);
+
+    // characters not allowed in literals are encoded, so the result is parsed back the same
+    const auto reserved = URI::Template::BindPartial(URI::Template::ParseTemplate("/{+name}{/id}"),
+                                                     {{"name", URI::Template::VarValue("O'Brien/%41")}});
+    ASSERT_EQ(reserved.String(), "/O%27Brien/%41{/id}");
+    ASSERT_EQ(URI::Template::ParseTemplate(reserved.String()).Parts(), reserved.Parts());
+
+    // undefined variables expand to nothing
+    const auto all_bound = URI::Template::BindPartial(URI::Template::ParseTemplate("/a{/undef}/b{?undef}"),
+                                                      {{"undef", URI::Template::VarValue()}});
+    ASSERT_EQ(all_bound.Size(), 1);
+    ASSERT_EQ(all_bound.String(), "/a/b");
+    ASSERT_FALSE(all_bound.IsTemplated());
+}
+
+TEST(ExpandScopes, Test)
+{
+    const std::unordered_map<std::string, URI::Template::VarValue> defaults = {
+        {"host", URI::Template::VarValue("example.com")},
+        {"lang", URI::Template::VarValue("en")},
+        {"page", URI::Template::VarValue("1")},
+    };
+    const std::unordered_map<std::string, URI::Template::VarValue> tenant = {
+        {"lang", URI::Template::VarValue("de")},
+        {"tenant", URI::Template::VarValue("acme")},
+    };
+    const URI::Template::ValueScope defaults_scope(defaults);
+    const URI::Template::ValueScope tenant_scope(tenant, &defaults_scope);
+
+    const auto uri_template = URI::Template::ParseTemplate("https://{host}{/tenant}/docs{?lang,page,q}");
+    for (const auto& page : {"2", "3"}) {
+        const std::unordered_map<std::string, URI::Template::VarValue> request = {
+            {"page", URI::Template::VarValue(page)},
+            {"q", URI::Template::VarValue("a b")},
+        };
+        const URI::Template::ValueScope request_scope(request, &tenant_scope);
+        ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, request_scope),
+                  std::string("https://example.com/acme/docs?lang=de&page=") + page + "&q=a%20b");
+    }
+
+    // undefined value in an inner scope hides the outer one
+    const std::unordered_map<std::string, URI::Template::VarValue> no_lang = {{"lang", URI::Template::VarValue()}};
+    const URI::Template::ValueScope no_lang_scope(no_lang, &tenant_scope);
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, no_lang_scope), "https://example.com/acme/docs?page=1");
+    ASSERT_EQ(URI::Template::ExpandExpression(uri_template[1].Get<URI::Template::Expression>(), defaults_scope),
+              "example.com");
+    ASSERT_EQ(tenant_scope.Find("missing"), nullptr);
+}
+
+TEST(ExpandBatch, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("https://example.com/items{/id}{?page,missing}");
+    std::vector<URI::Template::VarValue> ids;
+    std::vector<URI::Template::VarValue> pages;
+    for (int i = 0; i < 1000; ++i) {
+        ids.emplace_back(std::to_string(i) + (i % 7 ? "" : " x"));
+        if (i < 900) {
+            pages.emplace_back(i % 10);
+        }
+    }
+    const std::unordered_map<std::string, URI::Template::BoundValues> columns = {
+        {"id", ids}, {"page", pages}, {"other", ids}};
+
+    for (std::size_t threads : {1, 3, 0}) {
+        const auto batch = URI::Template::ExpandBatch(uri_template, columns, threads);
+        ASSERT_EQ(batch.Size(), ids.size());
+        ASSERT_EQ(batch.offsets.back(), batch.buffer.size());
+        for (std::size_t row = 0; row < batch.Size(); ++row) {
+            std::unordered_map<std::string, URI::Template::VarValue> values = {{"id", ids[row]}};
+            if (row < pages.size()) {
+                values.emplace("page", pages[row]);
+            }
+            ASSERT_EQ(batch[row], URI::Template::ExpandTemplate(uri_template, values)) << "row: " << row;
+        }
+    }
+
+    ASSERT_EQ(URI::Template::ExpandBatch(uri_template, {}, 4).Size(), 0);
+}
+
+TEST(ExpansionProduct, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("https://{host}/{region}/shop{/category}{?page,region}");
+    const URI::Template::ExpansionProduct product(
+        uri_template,
+        {{"region", {URI::Template::VarValue("eu"), URI::Template::VarValue("us west")}},
+         {"category", {URI::Template::VarValue("books"), URI::Template::VarValue("a/v"), URI::Template::VarValue()}},
+         {"page", {URI::Template::VarValue(1), URI::Template::VarValue(2)}}},
+        {{"host", URI::Template::VarValue("example.com")}});
+    ASSERT_EQ(product.Size(), 12);
+
+    std::vector<std::string> expected;
+    for (const auto& region : {"eu", "us west"}) {
+        for (const auto* category : {"books", "a/v", static_cast<const char*>(nullptr)}) {
+            for (int page : {1, 2}) {
+                std::unordered_map<std::string, URI::Template::VarValue> values = {
+                    {"host", URI::Template::VarValue("example.com")},
+                    {"region", URI::Template::VarValue(region)},
+                    {"page", URI::Template::VarValue(page)},
+                };
+                if (category) {
+                    values.emplace("category", URI::Template::VarValue(category));
+                }
+                expected.push_back(URI::Template::ExpandTemplate(uri_template, values));
+            }
+        }
+    }
+    ASSERT_EQ(expected[3], "https://example.com/eu/shop/a%2Fv?page=2&region=eu");
+
+    std::vector<std::string> expanded;
+    for (const auto& uri : product) {
+        expanded.push_back(uri);
+    }
+    ASSERT_EQ(expanded, expected);
+
+    // slices cover the product
+    expanded.clear();
+    for (std::size_t first = 0; first < product.Size(); first += 5) {
+        const auto slice = product.Slice(first, first + 5);
+        for (auto it = slice.begin(); it != slice.end(); ++it) {
+            ASSERT_EQ(it.Index(), expanded.size());
+            expanded.push_back(*it);
+        }
+    }
+    ASSERT_EQ(expanded, expected);
+    ASSERT_EQ(product.Slice(10, 100).Size(), 2);
+    ASSERT_EQ(product.Slice(100, 200).Size(), 0);
+    ASSERT_EQ(*product.Slice(7, 8).begin().Value("page"), URI::Template::VarValue(2));
+
+    const URI::Template::ExpansionProduct empty(uri_template, {{"page", {}}});
+    ASSERT_EQ(empty.Size(), 0);
+    ASSERT_TRUE(empty.begin() == empty.end());
+    const URI::Template::ExpansionProduct single(uri_template, {});
+    ASSERT_EQ(std::vector<std::string>(single.begin(), single.end()), std::vector<std::string>{"https:////shop"});
+}
+
+TEST(ExpandOutputLimit, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/search{?q,tags,n}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"q", URI::Template::VarValue("a b")},
+        {"tags", URI::Template::VarValue(std::vector<std::string>{"x", "y/z"})},
+        {"n", URI::Template::VarValue(42)},
+    };
+    const std::string expanded = URI::Template::ExpandTemplate(uri_template, values);
+    ASSERT_EQ(expanded, "/search?q=a%20b&tags=x,y%2Fz&n=42");
+
+    for (std::size_t limit = 0; limit <= expanded.size() + 1; ++limit) {
+        std::string result = "prefix";
+        const auto status = URI::Template::ExpandTemplate(uri_template, values, result, limit);
+        if (limit < expanded.size()) {
+            ASSERT_EQ(status, URI::Template::ExpansionStatus::OUTPUT_LIMIT_EXCEEDED) << limit;
+            ASSERT_EQ(result, "prefix");
+        } else {
+            ASSERT_EQ(status, URI::Template::ExpansionStatus::OK) << limit;
+            ASSERT_EQ(result, "prefix" + expanded);
+        }
+    }
+
+    // hostile values are rejected without building the expansion
+    std::string result;
+    const std::unordered_map<std::string, URI::Template::VarValue> huge = {
+        {"q", URI::Template::VarValue(std::string(10000000, ' '))},
+        {"tags", URI::Template::VarValue(std::vector<std::string>(1000000, "tag"))},
+    };
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, huge, result, 1024),
+              URI::Template::ExpansionStatus::OUTPUT_LIMIT_EXCEEDED);
+    ASSERT_TRUE(result.empty());
+    ASSERT_LE(result.capacity(), 2048);
+    ASSERT_EQ(URI::Template::ExpandTemplate(URI::Template::ParseTemplate("{q:3}"), huge, result, 9),
+              URI::Template::ExpansionStatus::OK);
+    ASSERT_EQ(result, "%20%20%20");
+}
+
+TEST(ExpandScattered, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("https://example.com/api/v1{/id}{?q}{&page}/end");
+    std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"id", URI::Template::VarValue("a b")},
+        {"page", URI::Template::VarValue(2)},
+    };
+
+    URI::Template::ScatteredExpansion result;
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    ASSERT_EQ(result.String(), URI::Template::ExpandTemplate(uri_template, values));
+    ASSERT_EQ(result.Size(), result.String().size());
+
+    // literal is referred to, adjacent expressions share a segment
+    const auto& segments = result.Segments();
+    ASSERT_EQ(segments.size(), 3);
+    ASSERT_EQ(segments[0].data, uri_template[0].Get<URI::Template::Literal>().String().data());
+    ASSERT_EQ(std::string(segments[1].data, segments[1].size), "/a%20b&page=2");
+    ASSERT_EQ(std::string(segments[2].data, segments[2].size), "/end");
+
+    // reuse
+    values["q"] = URI::Template::VarValue(std::string(1000, 'x'));
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    ASSERT_EQ(result.String(), URI::Template::ExpandTemplate(uri_template, values));
+    URI::Template::ExpandTemplate(uri_template, {}, result);
+    ASSERT_EQ(result.Segments().size(), 2);
+    ASSERT_EQ(result.String(), "https://example.com/api/v1/end");
+
+    // copies and moves refer to their own scratch buffers, short ones are stored inside the string
+    values.erase("q");
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    const auto expected = result.String();
+    auto copy = std::make_unique<URI::Template::ScatteredExpansion>(result);
+    URI::Template::ExpandTemplate(uri_template, {}, result);
+    ASSERT_EQ(copy->String(), expected);
+    URI::Template::ScatteredExpansion moved(std::move(*copy));
+    copy.reset();
+    ASSERT_EQ(moved.String(), expected);
+    URI::Template::ScatteredExpansion assigned;
+    assigned = moved;
+    moved = URI::Template::ScatteredExpansion();
+    ASSERT_EQ(assigned.String(), expected);
+    moved = std::move(assigned);
+    ASSERT_EQ(moved.String(), expected);
+
+#ifdef __unix__
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    const auto written = writev(fds[1], reinterpret_cast<const iovec*>(result.Segments().data()),
+                                static_cast<int>(result.Segments().size()));
+    ASSERT_EQ(written, static_cast<ssize_t>(result.Size()));
+    std::string read_back(result.Size(), '\0');
+    ASSERT_EQ(read(fds[0], read_back.data(), read_back.size()), written);
+    close(fds[0]);
+    close(fds[1]);
+    ASSERT_EQ(read_back, result.String());
+#endif
+}
+
+TEST(ExpandInto, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/search{?q,tags,n}");
+    const std::unordered_map<std::string, URI::Template::VarValue> values = {
+        {"q", URI::Template::VarValue("a b")},
+        {"tags", URI::Template::VarValue(std::vector<std::string>{"x", "y/z"})},
+        {"n", URI::Template::VarValue(42)},
+    };
+    const std::string expanded = URI::Template::ExpandTemplate(uri_template, values);
+
+    char buffer[64];
+    auto result = URI::Template::ExpandInto(uri_template, values, buffer, sizeof(buffer));
+    ASSERT_EQ(result.status, URI::Template::ExpansionStatus::OK);
+    ASSERT_EQ(std::string(buffer, result.size), expanded);
+
+    // truncated expansion reports the needed size and fills the buffer with its beginning
+    for (std::size_t capacity = 0; capacity < expanded.size(); ++capacity) {
+        std::memset(buffer, '!', sizeof(buffer));
+        result = URI::Template::ExpandInto(uri_template, values, buffer, capacity);
+        ASSERT_EQ(result.status, URI::Template::ExpansionStatus::TRUNCATED) << capacity;
+        ASSERT_EQ(result.size, expanded.size()) << capacity;
+        ASSERT_EQ(std::string(buffer, capacity), expanded.substr(0, capacity));
+        ASSERT_EQ(buffer[capacity], '!');
+    }
+    result = URI::Template::ExpandInto(uri_template, values, nullptr, 0);
+    ASSERT_EQ(result.status, URI::Template::ExpansionStatus::TRUNCATED);
+    ASSERT_EQ(result.size, expanded.size());
+
+    const std::unordered_map<std::string_view, URI::Template::VarValueView> views = {
+        {"q", URI::Template::VarValueView("a b")},
+    };
+    result = URI::Template::ExpandInto(uri_template, views, buffer, sizeof(buffer));
+    ASSERT_EQ(result.status, URI::Template::ExpansionStatus::OK);
+    ASSERT_EQ(std::string(buffer, result.size), "/search?q=a%20b");
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
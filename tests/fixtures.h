@@ -3,31 +3,6 @@
 #include "uri-template/uri-template.h"
 #include "gtest/gtest.h"
 
-namespace {
-    bool ExpandedEqual(const std::string& str1, const std::string& str2) {
-        if (str1 == str2) {
-            return true;
-        }
-        // DICT VarValue (std::unordered_map) may be expanded with any order
-        // Compare length and set of characteds
-        if (str1.length() != str2.length()) {
-            return false;
-        }
-
-        std::unordered_set<char> uri_characters;
-        for (const auto& c : str2) {
-            uri_characters.insert(c);
-        }
-        for (const auto& c : str1) {
-            if (uri_characters.count(c) == 0) {
-                return false;
-            }
-        }
-
-        return true;
-    }
-}
-
 struct TestParams
 {
     std::string uri_template_str;
@@ -96,14 +71,15 @@ protected:
             }
         }
 
+        // matched dictionaries keep the order of the uri, so expansion gives the same uri
         std::string expanded_str;
         try {
-            expanded_str = URI::Template::ExpandTemplate(uri_template, test_param.values);
+            expanded_str = URI::Template::ExpandTemplate(uri_template, matched_values);
         } catch (...) {
             return ::testing::AssertionFailure() << "'" << test_param.uri_template_str << "' is not expanded";
         }
 
-        if (!ExpandedEqual(expanded_str, test_param.uri_str)) {
+        if (expanded_str != test_param.uri_str) {
             return ::testing::AssertionFailure()
                    << "expanded '" << expanded_str << "' != expected '" << test_param.uri_str << "'";
         }
@@ -150,10 +126,29 @@ protected:
             return ::testing::AssertionFailure() << "'" << test_param.uri_template_str << "' is not expanded";
         }
 
-        if (!ExpandedEqual(expanded_str, test_param.uri_str)) {
+        if (expanded_str != test_param.uri_str) {
             return ::testing::AssertionFailure()
                    << "expanded '" << expanded_str << "' != expected '" << test_param.uri_str << "'";
         }
+
+        std::string compiled_str;
+        try {
+            compiled_str = URI::Template::CompiledExpander(uri_template).Expand(test_param.values);
+        } catch (...) {
+            return ::testing::AssertionFailure() << "'" << test_param.uri_template_str << "' is not compiled";
+        }
+
+        if (compiled_str != expanded_str) {
+            return ::testing::AssertionFailure()
+                   << "compiled expansion '" << compiled_str << "' != '" << expanded_str << "'";
+        }
+
+        const std::size_t expanded_size = URI::Template::ExpandedSize(uri_template, test_param.values);
+        if (expanded_size != expanded_str.size()) {
+            return ::testing::AssertionFailure()
+                   << "expanded size " << expanded_size << " != " << expanded_str.size() << " of '" << expanded_str
+                   << "'";
+        }
         return ::testing::AssertionSuccess();
     }
 };
@@ -1,5 +1,42 @@
 #include "fixtures.h"
 
+#include <array>
+#include <memory_resource>
+
+namespace {
+/**
+ * Memory resource which counts allocations and takes memory from the heap.
+ * Used as the default resource, to check that memory is taken from the arena only.
+ */
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    std::size_t Allocations() const
+    {
+        return allocations_;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        ++allocations_;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override
+    {
+        std::pmr::new_delete_resource()->deallocate(ptr, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+    std::size_t allocations_ = 0; ///< Number of allocations.
+};
+} // namespace
+
 TEST_P(TemplateMatch, Test)
 {
     ASSERT_TRUE(Matched(GetParam()));
@@ -954,6 +991,128 @@ INSTANTIATE_TEST_CASE_P(
 );
 // clang-format on
 
+TEST(MatchTyped, Test)
+{
+    using URI::Template::VarType;
+    using URI::Template::VarValue;
+
+    const auto uri_template = URI::Template::ParseTemplate("/items{/id}{?ratio,all,name,missing}");
+    const std::unordered_map<std::string, VarType> var_types = {
+        {"id", VarType::INT64},
+        {"ratio", VarType::DOUBLE},
+        {"all", VarType::BOOL},
+        {"missing", VarType::UINT64},
+    };
+
+    std::unordered_map<std::string, VarValue> values;
+    ASSERT_TRUE(
+        URI::Template::MatchURI(uri_template, "/items/-12?ratio=1e%2B300&all=false&name=x", var_types, &values));
+    ASSERT_EQ(values.at("id"), VarValue(-12));
+    ASSERT_EQ(values.at("ratio"), VarValue(1e300));
+    ASSERT_EQ(values.at("all"), VarValue(false));
+    ASSERT_EQ(values.at("name"), VarValue("x"));
+    ASSERT_EQ(values.at("missing"), VarValue());
+
+    // unmatched variables don't overwrite values already in the map, matched ones do
+    std::unordered_map<std::string, VarValue> prefilled = {
+        {"missing", VarValue(7u)},
+        {"all", VarValue(true)},
+        {"other", VarValue("kept")},
+    };
+    ASSERT_TRUE(URI::Template::MatchURI(uri_template, "/items/5?all=false", var_types, &prefilled));
+    ASSERT_EQ(prefilled.at("id"), VarValue(5));
+    ASSERT_EQ(prefilled.at("all"), VarValue(false));
+    ASSERT_EQ(prefilled.at("missing"), VarValue(7u));
+    ASSERT_EQ(prefilled.at("other"), VarValue("kept"));
+
+    ASSERT_FALSE(URI::Template::MatchURI(uri_template, "/items/abc", var_types));
+    ASSERT_FALSE(URI::Template::MatchURI(uri_template, "/items/1?all=yes", var_types));
+
+    ASSERT_EQ(URI::Template::ConvertVarValue(VarValue("42"), VarType::UINT64), VarValue(42u));
+    ASSERT_EQ(URI::Template::ConvertVarValue(VarValue("-42"), VarType::UINT64), std::nullopt);
+    ASSERT_EQ(URI::Template::ConvertVarValue(VarValue("42 "), VarType::INT64), std::nullopt);
+    ASSERT_EQ(URI::Template::ConvertVarValue(VarValue(VarType::LIST), VarType::INT64), std::nullopt);
+}
+
+TEST(MatchDictOrder, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/search{?keys*}");
+    const std::string uri = "/search?q=x&b=2&a=1";
+
+    std::unordered_map<std::string, URI::Template::VarValue> values;
+    ASSERT_TRUE(URI::Template::MatchURI(uri_template, uri, &values));
+    std::vector<std::string> keys;
+    for (const auto& [key, value] : values.at("keys").Get<URI::Template::VarDict>()) {
+        keys.push_back(key);
+    }
+    ASSERT_EQ(keys, (std::vector<std::string>{"q", "b", "a"}));
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), uri);
+
+    values.clear();
+    ASSERT_TRUE(URI::Template::MatchURI(uri_template, uri, &values, true));
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), "/search?a=1&b=2&q=x");
+
+    // many keys are matched in linear time
+    std::string many = "/search?";
+    for (int i = 0; i < 100000; ++i) {
+        many += "k" + std::to_string(i) + "=" + std::to_string(i) + "&";
+    }
+    many.pop_back();
+    values.clear();
+    ASSERT_TRUE(URI::Template::MatchURI(uri_template, many, &values));
+    ASSERT_EQ(values.at("keys").Get<URI::Template::VarDict>().size(), 100000);
+    ASSERT_EQ(values.at("keys").Get<URI::Template::VarDict>().at("k99999"), "99999");
+    ASSERT_EQ(URI::Template::ExpandTemplate(uri_template, values), many);
+}
+
+TEST(MatchIntoArena, Test)
+{
+    const auto uri_template = URI::Template::ParseTemplate("/users{/id}{?tags,empty}{&keys*}");
+    const std::string uri = "/users/john?tags=a,b&empty=&k1=v1&k2=v2";
+
+    std::array<std::byte, 4096> buffer;
+    std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    CountingResource heap;
+    std::pmr::unordered_map<std::string_view, URI::Template::VarValueView> values(&arena);
+    std::pmr::memory_resource* const default_resource = std::pmr::set_default_resource(&heap);
+    const bool matched = URI::Template::MatchURI(uri_template, uri, values);
+    std::pmr::set_default_resource(default_resource);
+    ASSERT_TRUE(matched);
+    ASSERT_EQ(heap.Allocations(), 0);
+
+    ASSERT_EQ(values.at("id").Get<std::string_view>(), "john");
+    ASSERT_EQ(values.at("tags").Get<URI::Template::VarValueView::List>().size(), 2);
+    ASSERT_EQ(values.at("empty").Get<std::string_view>(), "");
+    const auto keys = values.at("keys").Get<URI::Template::VarValueView::Dict>();
+    ASSERT_EQ(keys.size(), 2);
+    ASSERT_EQ(keys[0], (URI::Template::VarValueView::DictItem("k1", "v1")));
+
+    // expansion of the views doesn't leave the arena too
+    const std::pmr::string expanded = URI::Template::ExpandTemplate(uri_template, values, nullptr);
+    ASSERT_EQ(std::string_view(expanded), uri);
+    ASSERT_EQ(expanded.get_allocator().resource(), &arena);
+
+    std::pmr::string result("http://example.com", &arena);
+    URI::Template::ExpandTemplate(uri_template, values, result);
+    ASSERT_EQ(std::string_view(result), "http://example.com" + uri);
+
+    ASSERT_FALSE(URI::Template::MatchURI(uri_template, "/groups/john", values));
+
+    // sorted dictionary, values outlive the matched string
+    std::pmr::unordered_map<std::string_view, URI::Template::VarValueView> sorted(&arena);
+    auto sorted_uri = std::make_unique<std::string>("/users/jane?tags=c&empty=&k2=v2&k1=v1");
+    std::pmr::set_default_resource(&heap);
+    const bool sorted_matched = URI::Template::MatchURI(uri_template, *sorted_uri, sorted, true);
+    std::pmr::set_default_resource(default_resource);
+    sorted_uri.reset();
+    ASSERT_TRUE(sorted_matched);
+    ASSERT_EQ(heap.Allocations(), 0);
+    ASSERT_EQ(sorted.at("id").Get<std::string_view>(), "jane");
+    ASSERT_EQ(sorted.at("tags").Get<std::string_view>(), "c");
+    ASSERT_EQ(sorted.at("keys").Get<URI::Template::VarValueView::Dict>()[0],
+              (URI::Template::VarValueView::DictItem("k1", "v1")));
+}
+
 int main(int argc, char** argv)
 {
     ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,52 @@
+# Runs uri-template-expand and checks its exit code, output and error message.
+# Usage: cmake -DTOOL=... -DTEMPLATE=... -DINPUT=... [-D...] -P RunTool.cmake
+#
+#   TOOL      - path to uri-template-expand
+#   TEMPLATE  - template to expand, shouldn't have ';'
+#   INPUT     - input file
+#   STDIN     - read INPUT from standard input if set
+#   FORMAT    - input format option, optional
+#   THREADS   - number of worker threads, 1 by default
+#   EXPECTED  - file with the expected output, the output must be empty if not set
+#   EXIT_CODE - expected exit code, 0 by default
+#   ERROR     - regular expression to match the error message with, optional
+
+if(NOT THREADS)
+    set(THREADS 1)
+endif()
+if(NOT EXIT_CODE)
+    set(EXIT_CODE 0)
+endif()
+
+set(command "${TOOL}" --threads "${THREADS}")
+if(FORMAT)
+    list(APPEND command --format "${FORMAT}")
+endif()
+list(APPEND command "${TEMPLATE}")
+
+if(STDIN)
+    execute_process(COMMAND ${command} -
+                    INPUT_FILE "${INPUT}"
+                    OUTPUT_VARIABLE output
+                    ERROR_VARIABLE error
+                    RESULT_VARIABLE result)
+else()
+    execute_process(COMMAND ${command} "${INPUT}"
+                    OUTPUT_VARIABLE output
+                    ERROR_VARIABLE error
+                    RESULT_VARIABLE result)
+endif()
+
+if(NOT result EQUAL EXIT_CODE)
+    message(FATAL_ERROR "exit code ${result}, expected ${EXIT_CODE}\n${error}")
+endif()
+if(ERROR AND NOT error MATCHES "${ERROR}")
+    message(FATAL_ERROR "error message doesn't match '${ERROR}':\n${error}")
+endif()
+set(expected "")
+if(EXPECTED)
+    file(READ "${EXPECTED}" expected)
+endif()
+if(NOT output STREQUAL expected)
+    message(FATAL_ERROR "unexpected output:\n${output}\nexpected:\n${expected}")
+endif()
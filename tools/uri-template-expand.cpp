@@ -0,0 +1,749 @@
+#include <uri-template/uri-template.h>
+
+#include <algorithm>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+constexpr const char* kUsage = R"(Usage: uri-template-expand [OPTIONS] TEMPLATE [FILE]
+
+Expands TEMPLATE for every row of FILE (or standard input if FILE is '-' or omitted)
+and writes one URI per line to standard output, in order of the rows.
+
+Options:
+  -f, --format FORMAT  Input format: 'csv' or 'jsonl'. Defaults to 'jsonl' for *.jsonl and *.ndjson
+                       files and to 'csv' otherwise.
+  -j, --threads N      Number of worker threads, 0 means one per CPU (default).
+  -h, --help           Show this help.
+
+CSV input starts with a header of variables names. Fields may be quoted as per RFC 4180,
+empty fields are undefined variables. Empty and whitespace-only lines are skipped.
+Records longer than 1 MiB are an error.
+JSON-lines input has an object per line. Strings, numbers and booleans are scalar values,
+arrays of strings are lists, objects of strings are dictionaries, null is an undefined variable.
+Columns and keys which are not variables of TEMPLATE are ignored.
+)";
+
+/// Number of rows processed by a worker at once.
+constexpr std::size_t kChunkRows = 1024;
+
+/// Maximum size of a record, so an unterminated quoted field doesn't make the whole input buffered.
+constexpr std::size_t kMaxRecordSize = 1024 * 1024;
+
+/// Input format.
+enum class Format
+{
+    CSV, ///< comma-separated values with a header
+    JSON_LINES ///< JSON object per line
+};
+
+/// Command-line options.
+struct Options
+{
+    std::string uri_template; ///< Template to expand.
+    std::string input; ///< Input file, empty for standard input.
+    Format format = Format::CSV; ///< Input format.
+    std::size_t threads = 0; ///< Number of worker threads.
+};
+
+/// Parses command line into @p options, returns false if the tool should exit with @p exit_code.
+bool ParseOptions(int argc, char** argv, Options& options, int& exit_code)
+{
+    std::vector<std::string> positional;
+    const char* format = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            std::cout << kUsage;
+            exit_code = 0;
+            return false;
+        }
+        if (arg == "-f" || arg == "--format" || arg == "-j" || arg == "--threads") {
+            if (i + 1 == argc) {
+                std::cerr << "uri-template-expand: " << arg << " requires a value\n";
+                exit_code = 2;
+                return false;
+            }
+            const char* value = argv[++i];
+            if (arg == "-f" || arg == "--format") {
+                format = value;
+                continue;
+            }
+            const auto parsed = std::from_chars(value, value + std::strlen(value), options.threads);
+            if (parsed.ec != std::errc() || *parsed.ptr != '\0') {
+                std::cerr << "uri-template-expand: invalid number of threads '" << value << "'\n";
+                exit_code = 2;
+                return false;
+            }
+            continue;
+        }
+        if (arg.size() > 1 && arg[0] == '-') {
+            std::cerr << "uri-template-expand: unknown option " << arg << "\n" << kUsage;
+            exit_code = 2;
+            return false;
+        }
+        positional.push_back(arg);
+    }
+
+    if (positional.empty() || positional.size() > 2) {
+        std::cerr << kUsage;
+        exit_code = 2;
+        return false;
+    }
+    options.uri_template = positional[0];
+    if (positional.size() == 2 && positional[1] != "-") {
+        options.input = positional[1];
+    }
+
+    const auto ends_with = [](const std::string& str, std::string_view suffix) {
+        return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (format == nullptr) {
+        const bool json_lines = ends_with(options.input, ".jsonl") || ends_with(options.input, ".ndjson");
+        options.format = json_lines ? Format::JSON_LINES : Format::CSV;
+    } else if (std::strcmp(format, "csv") == 0) {
+        options.format = Format::CSV;
+    } else if (std::strcmp(format, "jsonl") == 0) {
+        options.format = Format::JSON_LINES;
+    } else {
+        std::cerr << "uri-template-expand: unknown format '" << format << "'\n";
+        exit_code = 2;
+        return false;
+    }
+
+    if (options.threads == 0) {
+        options.threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    return true;
+}
+
+/**
+ * Reads a single record of the input.
+ * CSV record may span several lines if a quoted field has line breaks.
+ * Empty and whitespace-only lines outside of quoted fields are skipped.
+ *
+ * @returns false at the end of the input.
+ * @throws std::runtime_error if the record is longer than kMaxRecordSize or a quoted field isn't terminated.
+ */
+bool ReadRecord(std::istream& input, Format format, std::string& record, std::size_t& line)
+{
+    record.clear();
+    std::string next;
+    bool quoted = false;
+    while (std::getline(input, next)) {
+        ++line;
+        if (!next.empty() && next.back() == '\r') {
+            next.pop_back();
+        }
+        if (!quoted && next.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+        if (quoted) {
+            record.push_back('\n');
+        }
+        record += next;
+        if (record.size() > kMaxRecordSize) {
+            throw std::runtime_error("record is longer than " + std::to_string(kMaxRecordSize) + " bytes");
+        }
+        if (format == Format::JSON_LINES) {
+            return true;
+        }
+        // quotes inside quoted fields are doubled, so odd number of quotes means an unterminated field
+        for (const char c : next) {
+            quoted ^= c == '"';
+        }
+        if (!quoted) {
+            return true;
+        }
+    }
+    if (quoted) {
+        throw std::runtime_error("unterminated quoted field");
+    }
+    return !record.empty();
+}
+
+/// Splits CSV @p record into @p fields.
+void ParseCsvRecord(std::string_view record, std::vector<std::string>& fields)
+{
+    fields.clear();
+    std::size_t pos = 0;
+    for (;;) {
+        std::string& field = fields.emplace_back();
+        if (pos < record.size() && record[pos] == '"') {
+            for (++pos;; ++pos) {
+                if (pos == record.size()) {
+                    throw std::runtime_error("unterminated quoted field");
+                }
+                if (record[pos] == '"') {
+                    if (pos + 1 < record.size() && record[pos + 1] == '"') {
+                        ++pos;
+                    } else {
+                        break;
+                    }
+                }
+                field.push_back(record[pos]);
+            }
+            ++pos;
+            if (pos < record.size() && record[pos] != ',') {
+                throw std::runtime_error("unexpected character after quoted field");
+            }
+        } else {
+            const std::size_t end = std::min(record.find(',', pos), record.size());
+            field.assign(record.substr(pos, end - pos));
+            pos = end;
+        }
+        if (pos == record.size()) {
+            return;
+        }
+        ++pos; // skip ','
+    }
+}
+
+/**
+ * Reader of a single JSON object with values supported by uri-template.
+ */
+class JsonReader
+{
+public:
+    /// Parametrized constructor.
+    explicit JsonReader(std::string_view text)
+        : text_(text)
+    {
+    }
+
+    /**
+     * Reads the object into @p values by slots.
+     * Keys which are not in @p slots are parsed, but ignored.
+     *
+     * @throws std::runtime_error if the text isn't a single supported object.
+     */
+    void ReadObject(const std::unordered_map<std::string, std::size_t>& slots,
+                    std::vector<URI::Template::VarValue>& values)
+    {
+        Expect('{');
+        if (!Consume('}')) {
+            do {
+                const std::string key = ReadString();
+                Expect(':');
+                URI::Template::VarValue value = ReadValue();
+                const auto slot = slots.find(key);
+                if (slot != slots.end()) {
+                    values[slot->second] = std::move(value);
+                }
+            } while (Consume(','));
+            Expect('}');
+        }
+        SkipSpace();
+        if (pos_ != text_.size()) {
+            Fail("unexpected characters after the object");
+        }
+    }
+
+private:
+    [[noreturn]] void Fail(const std::string& message) const
+    {
+        throw std::runtime_error(message + " at column " + std::to_string(pos_ + 1));
+    }
+
+    void SkipSpace()
+    {
+        while (pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n')) {
+            ++pos_;
+        }
+    }
+
+    /// Skips @p c if it's the next character after spaces.
+    bool Consume(char c)
+    {
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+
+    void Expect(char c)
+    {
+        if (!Consume(c)) {
+            Fail(std::string("expected '") + c + "'");
+        }
+    }
+
+    /// Reads a literal word like 'true'.
+    bool ConsumeWord(std::string_view word)
+    {
+        if (text_.substr(pos_, word.size()) == word) {
+            pos_ += word.size();
+            return true;
+        }
+        return false;
+    }
+
+    /// Reads 4 hex digits of \u escape.
+    unsigned ReadHex4()
+    {
+        unsigned code = 0;
+        if (pos_ + 4 > text_.size() ||
+            std::from_chars(text_.data() + pos_, text_.data() + pos_ + 4, code, 16).ptr != text_.data() + pos_ + 4) {
+            Fail("invalid unicode escape");
+        }
+        pos_ += 4;
+        return code;
+    }
+
+    /// Appends UTF-8 encoding of @p code to @p str.
+    static void AppendUtf8(std::string& str, unsigned code)
+    {
+        if (code < 0x80) {
+            str.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            str.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            str.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            str.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            str.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            str.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            str.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    std::string ReadString()
+    {
+        Expect('"');
+        std::string str;
+        for (;;) {
+            if (pos_ == text_.size()) {
+                Fail("unterminated string");
+            }
+            const char c = text_[pos_++];
+            if (c == '"') {
+                return str;
+            }
+            if (static_cast<unsigned char>(c) < 0x20) {
+                Fail("control character in string");
+            }
+            if (c != '\\') {
+                str.push_back(c);
+                continue;
+            }
+            if (pos_ == text_.size()) {
+                Fail("unterminated string");
+            }
+            switch (text_[pos_++]) {
+            case '"':
+                str.push_back('"');
+                break;
+            case '\\':
+                str.push_back('\\');
+                break;
+            case '/':
+                str.push_back('/');
+                break;
+            case 'b':
+                str.push_back('\b');
+                break;
+            case 'f':
+                str.push_back('\f');
+                break;
+            case 'n':
+                str.push_back('\n');
+                break;
+            case 'r':
+                str.push_back('\r');
+                break;
+            case 't':
+                str.push_back('\t');
+                break;
+            case 'u': {
+                unsigned code = ReadHex4();
+                if (code >= 0xD800 && code < 0xDC00) {
+                    if (!ConsumeWord("\\u")) {
+                        Fail("unpaired surrogate");
+                    }
+                    const unsigned low = ReadHex4();
+                    if (low < 0xDC00 || low >= 0xE000) {
+                        Fail("unpaired surrogate");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                }
+                AppendUtf8(str, code);
+            } break;
+            default:
+                Fail("invalid escape");
+            }
+        }
+    }
+
+    URI::Template::VarValue ReadNumber()
+    {
+        const std::size_t begin = pos_;
+        bool integral = true;
+        while (pos_ < text_.size() && std::strchr("+-0123456789.eE", text_[pos_]) != nullptr) {
+            integral = integral && std::strchr(".eE", text_[pos_]) == nullptr;
+            ++pos_;
+        }
+        const char* first = text_.data() + begin;
+        const char* last = text_.data() + pos_;
+        if (integral) {
+            std::int64_t int_value;
+            const auto parsed_int = std::from_chars(first, last, int_value);
+            if (parsed_int.ec == std::errc() && parsed_int.ptr == last) {
+                return URI::Template::VarValue(int_value);
+            }
+            std::uint64_t uint_value;
+            const auto parsed_uint = std::from_chars(first, last, uint_value);
+            if (parsed_uint.ec == std::errc() && parsed_uint.ptr == last) {
+                return URI::Template::VarValue(uint_value);
+            }
+        }
+        double double_value;
+        const auto parsed = std::from_chars(first, last, double_value);
+        if (begin == pos_ || parsed.ptr != last || parsed.ec != std::errc()) {
+            pos_ = begin;
+            Fail("invalid value");
+        }
+        return URI::Template::VarValue(double_value);
+    }
+
+    URI::Template::VarValue ReadValue()
+    {
+        SkipSpace();
+        if (pos_ == text_.size()) {
+            Fail("expected a value");
+        }
+        switch (text_[pos_]) {
+        case '"':
+            return URI::Template::VarValue(ReadString());
+
+        case '[': {
+            ++pos_;
+            std::vector<std::string> list;
+            if (!Consume(']')) {
+                do {
+                    SkipSpace();
+                    if (pos_ == text_.size() || text_[pos_] != '"') {
+                        Fail("list items should be strings");
+                    }
+                    list.push_back(ReadString());
+                } while (Consume(','));
+                Expect(']');
+            }
+            return URI::Template::VarValue(std::move(list));
+        }
+
+        case '{': {
+            ++pos_;
+            URI::Template::VarDict dict;
+            if (!Consume('}')) {
+                do {
+                    std::string key = ReadString();
+                    Expect(':');
+                    SkipSpace();
+                    if (pos_ == text_.size() || text_[pos_] != '"') {
+                        Fail("dictionary values should be strings");
+                    }
+                    dict.insert_or_assign(std::move(key), ReadString());
+                } while (Consume(','));
+                Expect('}');
+            }
+            return URI::Template::VarValue(std::move(dict));
+        }
+
+        default:
+            if (ConsumeWord("true")) {
+                return URI::Template::VarValue(true);
+            }
+            if (ConsumeWord("false")) {
+                return URI::Template::VarValue(false);
+            }
+            if (ConsumeWord("null")) {
+                return URI::Template::VarValue();
+            }
+            return ReadNumber();
+        }
+    }
+
+    std::string_view text_; ///< Text of the object.
+    std::size_t pos_ = 0; ///< Current position in text_.
+};
+
+/// Rows of the input processed by a worker at once.
+struct Chunk
+{
+    std::vector<std::string> records; ///< Input records.
+    std::vector<std::size_t> lines; ///< Line number of each record.
+    std::string output; ///< Expansions, one per line.
+    std::string error; ///< Error of the first bad record, output has expansions of the records before it.
+    bool done = false; ///< If the chunk is processed.
+};
+
+/**
+ * Expands the template for records in order of the input.
+ * Reading thread hands chunks of records to worker threads, a writer thread outputs processed chunks in order.
+ * Number of chunks in flight is limited, so memory use doesn't depend on the input size.
+ */
+class Pipeline
+{
+public:
+    /// Parametrized constructor.
+    Pipeline(const URI::Template::CompiledExpander& expander, Format format, std::vector<std::string> header,
+             std::size_t threads)
+        : expander_(expander)
+        , format_(format)
+        , max_in_flight_(threads * 2)
+    {
+        if (format_ == Format::CSV) {
+            for (const auto& name : header) {
+                const auto slot = expander_.VariableIndex(name);
+                columns_.push_back(slot ? *slot : kNoSlot);
+            }
+        } else {
+            const auto& names = expander_.VariableNames();
+            for (std::size_t slot = 0; slot < names.size(); ++slot) {
+                slots_.emplace(names[slot], slot);
+            }
+        }
+
+        writer_ = std::thread(&Pipeline::Write, this);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back(&Pipeline::Work, this);
+        }
+    }
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    ~Pipeline()
+    {
+        Finish();
+    }
+
+    /**
+     * Queues the @p chunk, waiting while too many chunks are in flight.
+     *
+     * @returns false if processing has failed and no more chunks are needed.
+     */
+    bool Push(std::shared_ptr<Chunk> chunk)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [this] { return pending_.size() < max_in_flight_ || failed_; });
+        if (failed_) {
+            return false;
+        }
+        pending_.push_back(chunk);
+        todo_.push_back(std::move(chunk));
+        changed_.notify_all();
+        return true;
+    }
+
+    /**
+     * Waits until all queued chunks are written.
+     *
+     * @returns false if processing has failed.
+     */
+    bool Finish()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            input_done_ = true;
+            changed_.notify_all();
+        }
+        for (auto& worker : workers_) {
+            worker.join();
+        }
+        workers_.clear();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        return !failed_;
+    }
+
+private:
+    static constexpr std::size_t kNoSlot = std::numeric_limits<std::size_t>::max();
+
+    /// Worker thread: takes chunks from todo_ and expands them.
+    void Work()
+    {
+        std::vector<URI::Template::VarValue> values(expander_.VariableNames().size());
+        std::vector<std::string> fields;
+        for (;;) {
+            std::shared_ptr<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [this] { return !todo_.empty() || input_done_ || failed_; });
+                if (todo_.empty() || failed_) {
+                    return;
+                }
+                chunk = std::move(todo_.front());
+                todo_.pop_front();
+            }
+
+            for (std::size_t i = 0; i < chunk->records.size(); ++i) {
+                try {
+                    ParseRecord(chunk->records[i], values, fields);
+                    expander_.Expand(values, chunk->output);
+                    chunk->output.push_back('\n');
+                } catch (const std::exception& exc) {
+                    chunk->error = "line " + std::to_string(chunk->lines[i]) + ": " + exc.what();
+                    break;
+                }
+            }
+            chunk->records.clear();
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            chunk->done = true;
+            changed_.notify_all();
+        }
+    }
+
+    /// Fills @p values by slots from the @p record.
+    void ParseRecord(const std::string& record, std::vector<URI::Template::VarValue>& values,
+                     std::vector<std::string>& fields) const
+    {
+        for (auto& value : values) {
+            value = URI::Template::VarValue();
+        }
+        if (format_ == Format::JSON_LINES) {
+            JsonReader(record).ReadObject(slots_, values);
+            return;
+        }
+
+        ParseCsvRecord(record, fields);
+        if (fields.size() != columns_.size()) {
+            throw std::runtime_error("expected " + std::to_string(columns_.size()) + " fields, got " +
+                                     std::to_string(fields.size()));
+        }
+        for (std::size_t i = 0; i < fields.size(); ++i) {
+            if (columns_[i] != kNoSlot && !fields[i].empty()) {
+                values[columns_[i]] = URI::Template::VarValue(std::move(fields[i]));
+            }
+        }
+    }
+
+    /// Writer thread: outputs processed chunks in order.
+    void Write()
+    {
+        for (;;) {
+            std::shared_ptr<Chunk> chunk;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                changed_.wait(lock, [this] {
+                    return (!pending_.empty() && pending_.front()->done) || (pending_.empty() && input_done_);
+                });
+                if (pending_.empty()) {
+                    return;
+                }
+                chunk = std::move(pending_.front());
+                pending_.pop_front();
+                changed_.notify_all();
+            }
+
+            const bool written = std::fwrite(chunk->output.data(), 1, chunk->output.size(), stdout) ==
+                                 chunk->output.size();
+            if (!written || !chunk->error.empty()) {
+                std::cerr << "uri-template-expand: " << (written ? chunk->error : "failed to write output") << "\n";
+                std::lock_guard<std::mutex> lock(mutex_);
+                failed_ = true;
+                changed_.notify_all();
+                return;
+            }
+        }
+    }
+
+    const URI::Template::CompiledExpander& expander_; ///< Compiled template.
+    Format format_; ///< Input format.
+    std::vector<std::size_t> columns_; ///< Slots of CSV columns, kNoSlot for unknown variables.
+    std::unordered_map<std::string, std::size_t> slots_; ///< Slots of variables by names, for JSON.
+    std::size_t max_in_flight_; ///< Maximum number of chunks read, but not written yet.
+
+    std::mutex mutex_; ///< Guards the queues and flags.
+    std::condition_variable changed_; ///< Notified on any change of the queues and flags.
+    std::deque<std::shared_ptr<Chunk>> pending_; ///< Chunks in order of the input, until written.
+    std::deque<std::shared_ptr<Chunk>> todo_; ///< Chunks waiting for a worker.
+    bool input_done_ = false; ///< If all chunks are queued.
+    bool failed_ = false; ///< If processing has failed.
+
+    std::vector<std::thread> workers_; ///< Worker threads.
+    std::thread writer_; ///< Writer thread.
+};
+
+/// Reads the input and runs the pipeline, returns the exit code.
+int Run(const Options& options, std::istream& input)
+{
+    const URI::Template::CompiledExpander expander(URI::Template::ParseTemplate(options.uri_template));
+
+    std::size_t line = 0;
+    std::string record;
+    std::vector<std::string> header;
+    if (options.format == Format::CSV) {
+        if (!ReadRecord(input, options.format, record, line)) {
+            return 0;
+        }
+        ParseCsvRecord(record, header);
+    }
+
+    Pipeline pipeline(expander, options.format, std::move(header), options.threads);
+    bool reading = true;
+    while (reading) {
+        auto chunk = std::make_shared<Chunk>();
+        try {
+            while (chunk->records.size() < kChunkRows && ReadRecord(input, options.format, record, line)) {
+                chunk->records.push_back(std::move(record));
+                chunk->lines.push_back(line);
+            }
+        } catch (const std::exception& exc) {
+            chunk->error = "line " + std::to_string(line) + ": " + exc.what();
+        }
+        reading = chunk->records.size() == kChunkRows && chunk->error.empty();
+        if (chunk->records.empty() && chunk->error.empty()) {
+            break;
+        }
+        if (!pipeline.Push(std::move(chunk))) {
+            break;
+        }
+    }
+    return pipeline.Finish() && !input.bad() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::ios::sync_with_stdio(false);
+
+    Options options;
+    int exit_code = 0;
+    if (!ParseOptions(argc, argv, options, exit_code)) {
+        return exit_code;
+    }
+
+    try {
+        if (options.input.empty()) {
+            return Run(options, std::cin);
+        }
+        std::ifstream input(options.input);
+        if (!input) {
+            std::cerr << "uri-template-expand: can't open " << options.input << "\n";
+            return 1;
+        }
+        return Run(options, input);
+    } catch (const std::exception& exc) {
+        std::cerr << "uri-template-expand: " << exc.what() << "\n";
+        return 1;
+    }
+}